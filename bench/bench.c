@@ -0,0 +1,763 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                  bench.c                     *
+ ************************************************
+ * Microbenchmarks for the tokenizer, command   *
+ * lookup and starting pipelines. Built and run *
+ * with make bench. Results are percentiles of  *
+ * per operation times, as a table or as JSON   *
+ * lines that a later run can be checked        *
+ * against                                      *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/sush.h"
+#include "../includes/tokenizer.h"
+#include "../includes/executor.h"
+#include "../includes/cmdhash.h"
+#include "../includes/options.h"
+#include "../includes/jobs.h"
+#include "../includes/timing.h"
+#include "../includes/vars.h"
+#include "../includes/wildcard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define MAX_RESULTS 64
+#define MAX_EXTRA 3
+#define PATH_DIRS 64    // dirs in the synthetic $PATH
+#define PATH_FILES 256  // commands in each of them
+#define TOK_BATCH 64    // lines tokenized per timed sample
+#define MIN_SAMPLES 20  // taken even if they go over the time budget
+#define LONG_LINE 1000  // stages in the long pipeline checks
+
+/* one benchmark's samples, each the time of one operation */
+struct result {
+    char name[48];
+    const char *unit;
+    long long *ns;
+    int ct;
+    int cap;
+    const char *extra_name[MAX_EXTRA];
+    double extra[MAX_EXTRA];
+    int extra_ct;
+};
+
+static struct result results[MAX_RESULTS];
+static int result_ct = 0;
+static long long budget = 1000000000; // ns per benchmark, less with --quick
+static const char *only = NULL; // run only benchmarks starting with this
+static unsigned long heap_allocs = 0;
+static char sandbox[] = "/tmp/sush-bench-XXXXXX";
+
+void *__real_malloc (size_t);
+void *__real_calloc (size_t, size_t);
+void *__real_realloc (void *, size_t);
+
+static bool wanted (const char *);
+static struct result *new_result (const char *, const char *, int);
+static bool more_samples (struct result *, long long);
+static void add_extra (struct result *, const char *, double);
+static void bench_tokenize (const char *, char **, int);
+static void bench_lookup ();
+static void bench_glob ();
+static void count_match (const char *, void *);
+static void bench_spawn (const char *, int, const char *);
+static bool check_fds (const char *);
+static int count_fds ();
+static void make_corpus (char ***, char ***, char ***, int);
+static bool make_path ();
+static void remove_path ();
+static int by_ns (const void *, const void *);
+static long long percentile (struct result *, int);
+static void print_table ();
+static void print_json ();
+static int check_baseline (const char *, int);
+static void usage ();
+
+/**
+ * bench [--quick] [--json] [--baseline file [--tolerance pct]] [prefix]
+ * runs every benchmark, or the ones whose names start with prefix,
+ * each for about a second (a tenth of one with --quick). with
+ * --baseline, exits 1 if any p50 is more than pct percent
+ * (default 25) slower than in file, a previous run's --json output
+ */
+int main (int argc, char **argv)
+{
+    bool json = false;
+    const char *baseline = NULL;
+    int tolerance = 25;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            budget /= 10;
+        } else if (!strcmp(argv[i], "--json")) {
+            json = true;
+        } else if (!strcmp(argv[i], "--baseline") && i+1 < argc) {
+            baseline = argv[++i];
+        } else if (!strcmp(argv[i], "--tolerance") && i+1 < argc) {
+            tolerance = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && only == NULL) {
+            only = argv[i];
+        } else {
+            usage();
+        }
+    }
+
+    jobs_init(false);
+
+    char **short_lines;
+    char **long_lines;
+    char **quoted_lines;
+    int line_ct = 1024;
+    make_corpus(&short_lines, &long_lines, &quoted_lines, line_ct);
+    bench_tokenize("tokenize/short", short_lines, line_ct);
+    bench_tokenize("tokenize/long", long_lines, line_ct);
+    bench_tokenize("tokenize/quoted", quoted_lines, line_ct);
+
+    /* find the real true before $PATH is pointed at the sandbox */
+    const char *true_bin = cmd_lookup("true");
+    char *true_path = true_bin ? strdup(true_bin) : NULL;
+    const char *ls_bin = cmd_lookup("ls");
+    char *ls_path = ls_bin ? strdup(ls_bin) : NULL;
+    bool leaked = false;
+    if ((wanted("lookup") || wanted("spawn") || wanted("glob"))
+            && make_path()) {
+        bench_lookup();
+        bench_glob();
+        if (true_path != NULL) {
+            char link[sizeof(sandbox) + 32];
+            snprintf(link, sizeof(link), "%s/d0/sush-bench-true", sandbox);
+            symlink(true_path, link);
+            bench_spawn("spawn/posix", 1, "posix");
+            bench_spawn("spawn/posix", 2, "posix");
+            bench_spawn("spawn/posix", 16, "posix");
+            bench_spawn("spawn/fork", 1, "fork");
+            bench_spawn("spawn/fork", 2, "fork");
+            bench_spawn("spawn/fork", 16, "fork");
+            bench_spawn("spawn/posix", LONG_LINE, "posix");
+            if (ls_path != NULL) {
+                leaked = check_fds(ls_path);
+            }
+        }
+        bench_spawn("spawn/builtin", 1, "posix");
+        remove_path();
+    }
+    free(true_path);
+    free(ls_path);
+
+    if (json) {
+        print_json();
+    } else {
+        print_table();
+    }
+    if (leaked) {
+        return 1;
+    }
+    return baseline ? check_baseline(baseline, tolerance) : 0;
+}
+
+/**
+ * tokenizes every line of the corpus over and over, timing batches
+ * of TOK_BATCH lines. also counts how many heap and arena
+ * allocations each line costs
+ */
+static void bench_tokenize (const char *name, char **lines, int line_ct)
+{
+    if (!wanted(name)) {
+        return;
+    }
+    struct result *r = new_result(name, "line", 20000);
+
+    struct tok_list tlist;
+    init_tok_list(&tlist);
+    size_t bytes = 0;
+    int lens[line_ct];
+    for (int i = 0; i < line_ct; i++) {
+        lens[i] = strlen(lines[i]);
+    }
+
+    /* one pass first so the list's arrays have grown to size */
+    for (int i = 0; i < line_ct; i++) {
+        int used;
+        tokenize_chunk(&tlist, lines[i], lens[i], &used);
+        free_tok_list(&tlist);
+    }
+
+    struct arena_stats before;
+    arena_get_stats(&before);
+    unsigned long heap_before = heap_allocs;
+    int line = 0;
+    for (long long began = monotonic_ns(); more_samples(r, began);) {
+        long long start = monotonic_ns();
+        for (int b = 0; b < TOK_BATCH; b++) {
+            int used;
+            tokenize_chunk(&tlist, lines[line], lens[line], &used);
+            free_tok_list(&tlist);
+            bytes += lens[line];
+            line = (line + 1) % line_ct;
+        }
+        r->ns[r->ct++] = (monotonic_ns() - start) / TOK_BATCH;
+    }
+    struct arena_stats after;
+    arena_get_stats(&after);
+    destroy_tok_list(&tlist);
+
+    double total = (double)r->ct * TOK_BATCH;
+    long long sum = 0;
+    for (int i = 0; i < r->ct; i++) {
+        sum += r->ns[i] * TOK_BATCH;
+    }
+    add_extra(r, "MB/s", sum ? bytes / (sum / 1e9) / 1e6 : 0);
+    add_extra(r, "mallocs/line", (heap_allocs - heap_before) / total);
+    add_extra(r, "arena/line", (after.allocs - before.allocs) / total);
+}
+
+/**
+ * looks commands up in a $PATH of PATH_DIRS dirs of PATH_FILES
+ * commands each. cold lookups search the dirs, warm ones are hash
+ * table hits, misses are remembered after the first search. newline
+ * is the first lookup of a command line, which looks at the dirs
+ */
+static void bench_lookup ()
+{
+    char last[32];
+    snprintf(last, sizeof(last), "cmd%d_%d", PATH_DIRS-1, PATH_FILES-1);
+
+    if (wanted("lookup/cold")) {
+        struct result *r = new_result("lookup/cold", "lookup", 20000);
+        for (long long began = monotonic_ns(); more_samples(r, began);) {
+            cmd_hash_forget();
+            long long start = monotonic_ns();
+            cmd_lookup(last);
+            r->ns[r->ct++] = monotonic_ns() - start;
+        }
+        add_extra(r, "dirs", PATH_DIRS);
+    }
+
+    if (wanted("lookup/warm")) {
+        struct result *r = new_result("lookup/warm", "lookup", 200000);
+        cmd_lookup(last);
+        for (long long began = monotonic_ns(); more_samples(r, began);) {
+            long long start = monotonic_ns();
+            cmd_lookup(last);
+            r->ns[r->ct++] = monotonic_ns() - start;
+        }
+    }
+
+    if (wanted("lookup/newline")) {
+        struct result *r = new_result("lookup/newline", "lookup", 200000);
+        cmd_lookup(last);
+        for (long long began = monotonic_ns(); more_samples(r, began);) {
+            long long start = monotonic_ns();
+            cmd_hash_new_line();
+            cmd_lookup(last);
+            r->ns[r->ct++] = monotonic_ns() - start;
+        }
+        add_extra(r, "dirs", PATH_DIRS);
+    }
+
+    if (wanted("lookup/miss")) {
+        struct result *r = new_result("lookup/miss", "lookup", 200000);
+        cmd_lookup("sush-bench-nothere");
+        for (long long began = monotonic_ns(); more_samples(r, began);) {
+            long long start = monotonic_ns();
+            cmd_lookup("sush-bench-nothere");
+            r->ns[r->ct++] = monotonic_ns() - start;
+        }
+    }
+}
+
+/**
+ * expands patterns over the PATH_DIRS dirs of PATH_FILES files in the
+ * sandbox. glob/flat reads one dir, glob/dirs every dir named by a
+ * wildcard, glob/recursive walks the whole sandbox for a **
+ */
+static void bench_glob ()
+{
+    const char *names[] = { "glob/flat", "glob/dirs", "glob/recursive" };
+    const char *patterns[] = { "d0/cmd0_*", "d*/cmd*_7", "**/cmd*_7" };
+    for (int i = 0; i < 3; i++) {
+        if (!wanted(names[i])) {
+            continue;
+        }
+        char pattern[sizeof(sandbox) + 32];
+        snprintf(pattern, sizeof(pattern), "%s/%s", sandbox, patterns[i]);
+        struct result *r = new_result(names[i], "glob", 20000);
+        long matches = 0;
+        for (long long began = monotonic_ns(); more_samples(r, began);) {
+            long long start = monotonic_ns();
+            wildcard_expand(pattern, count_match, &matches);
+            r->ns[r->ct++] = monotonic_ns() - start;
+        }
+        add_extra(r, "matches", (double)matches / r->ct);
+    }
+}
+
+/**
+ * wildcard_expand() callback for bench_glob()
+ */
+static void count_match (const char *path, void *arg)
+{
+    (*(long *)arg)++;
+}
+
+/**
+ * times execute() on a line of stages copies of a command that exits
+ * right away, from starting the first stage until the last is
+ * reaped. spawn/builtin runs the true builtin instead, which never
+ * leaves the shell
+ */
+static void bench_spawn (const char *prefix, int stages, const char *mode)
+{
+    char name[48];
+    snprintf(name, sizeof(name), "%s/%d", prefix, stages);
+    bool builtin = strstr(prefix, "builtin") != NULL;
+    if (builtin) {
+        snprintf(name, sizeof(name), "%s", prefix);
+    }
+    if (!wanted(name)) {
+        return;
+    }
+
+    const char *cmd = builtin ? "true" : "sush-bench-true";
+    char line[stages * 20 + 2];
+    line[0] = '\0';
+    for (int i = 0; i < stages; i++) {
+        strcat(line, i ? " | " : "");
+        strcat(line, cmd);
+    }
+    strcat(line, "\n");
+
+    struct tok_list tlist;
+    init_tok_list(&tlist);
+    int used;
+    tokenize_chunk(&tlist, line, strlen(line), &used);
+    set_option("spawn", mode);
+
+    /* a long line takes half a second, a few runs of it will do */
+    struct result *r = new_result(name, "line",
+            stages >= LONG_LINE ? 5 : 200000);
+    for (long long began = monotonic_ns(); more_samples(r, began);) {
+        long long start = monotonic_ns();
+        execute(&tlist);
+        r->ns[r->ct++] = monotonic_ns() - start;
+    }
+    add_extra(r, "stages", stages);
+    set_option("spawn", "posix");
+    destroy_tok_list(&tlist);
+}
+
+/**
+ * runs a LONG_LINE stage pipeline whose last stage lists the fds it
+ * was started with, once per spawn mode. it should have only stdin,
+ * stdout, stderr and the directory ls has open, whatever the length
+ * of the line, and the shell should be left with no more fds than it
+ * had. returns true and says so if either isn't the case
+ */
+static bool check_fds (const char *ls_path)
+{
+    if (!wanted("spawn/fds")) {
+        return false;
+    }
+    char link[sizeof(sandbox) + 32];
+    snprintf(link, sizeof(link), "%s/d0/sush-bench-ls", sandbox);
+    symlink(ls_path, link);
+    char out[sizeof(sandbox) + 32];
+    snprintf(out, sizeof(out), "%s/fds", sandbox);
+
+    char *line = malloc(LONG_LINE * 20 + sizeof(out) + 64);
+    if (line == NULL) {
+        perror("malloc failed in check_fds()");
+        exit(-1);
+    }
+    line[0] = '\0';
+    for (int i = 0; i < LONG_LINE - 1; i++) {
+        strcat(line, "sush-bench-true | ");
+    }
+    sprintf(line + strlen(line), "sush-bench-ls /proc/self/fd > %s\n", out);
+
+    struct tok_list tlist;
+    init_tok_list(&tlist);
+    int used;
+    tokenize_chunk(&tlist, line, strlen(line), &used);
+
+    bool leaked = false;
+    const char *modes[] = { "posix", "fork" };
+    for (int m = 0; m < 2; m++) {
+        set_option("spawn", modes[m]);
+        unlink(out);
+        int before = count_fds();
+        execute(&tlist);
+        int after = count_fds();
+        int seen = -1; // lines ls wrote, one per fd
+        FILE *f = fopen(out, "r");
+        if (f != NULL) {
+            seen = 0;
+            for (int c; (c = getc(f)) != EOF;) {
+                seen += c == '\n';
+            }
+            fclose(f);
+        }
+        if (seen != 4 || after != before) {
+            fprintf(stderr, "spawn/fds: with spawn %s the last of %d stages "
+                    "had %d fds (want 4) and the shell went from %d to %d\n",
+                    modes[m], LONG_LINE, seen, before, after);
+            leaked = true;
+        }
+    }
+    set_option("spawn", "posix");
+    destroy_tok_list(&tlist);
+    free(line);
+    return leaked;
+}
+
+/**
+ * how many fds this process has open
+ */
+static int count_fds ()
+{
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == NULL) {
+        return -1;
+    }
+    int ct = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        ct += ent->d_name[0] != '.';
+    }
+    closedir(dir);
+    return ct - 1; // the one opendir() used
+}
+
+/**
+ * builds the three tokenizer corpora: short command lines, lines with
+ * a couple hundred args, and lines full of quotes and escapes
+ */
+static void make_corpus (char ***short_lines, char ***long_lines,
+        char ***quoted_lines, int ct)
+{
+    static const char *shorts[] = {
+        "ls -l\n", "cat file.txt | grep foo > out\n", "cd /tmp\n",
+        "echo hello world\n", "sort < in | uniq -c | sort -rn >> counts\n",
+        "make -j8\n", "git status\n", "ps aux | grep sush | wc -l\n",
+    };
+    static const char *quoted[] = {
+        "echo \"a \\\"quoted\\\" word\" 'single | quoted' plain\\ space\n",
+        "printf '%s\\n' \"x > y\" 'a<b' \"tab\\there\" \"\\|\\>\\<\"\n",
+        "grep -e \"^[a-z]* \\\"\" -e 'it'\"'\"'s' file\\ name.txt\n",
+    };
+    *short_lines = malloc(ct * sizeof(char *));
+    *long_lines = malloc(ct * sizeof(char *));
+    *quoted_lines = malloc(ct * sizeof(char *));
+    if (*short_lines == NULL || *long_lines == NULL || *quoted_lines == NULL) {
+        perror("malloc failed in make_corpus()");
+        exit(-1);
+    }
+
+    int n_short = sizeof(shorts) / sizeof(shorts[0]);
+    int n_quoted = sizeof(quoted) / sizeof(quoted[0]);
+    for (int i = 0; i < ct; i++) {
+        (*short_lines)[i] = strdup(shorts[i % n_short]);
+        (*quoted_lines)[i] = strdup(quoted[i % n_quoted]);
+
+        int args = 150 + i % 100;
+        char *line = malloc(args * 24 + 16);
+        if (line == NULL) {
+            perror("malloc failed in make_corpus()");
+            exit(-1);
+        }
+        char *end = line + sprintf(line, "gcc");
+        for (int a = 0; a < args; a++) {
+            end += sprintf(end, " -Isrc/module%d/include", (i + a) % 97);
+        }
+        strcpy(end, "\n");
+        (*long_lines)[i] = line;
+    }
+}
+
+/**
+ * fills the sandbox with PATH_DIRS dirs of PATH_FILES empty
+ * executables and points $PATH at them. returns false if it
+ * couldn't
+ */
+static bool make_path ()
+{
+    if (mkdtemp(sandbox) == NULL) {
+        perror("bench: mkdtemp");
+        return false;
+    }
+    size_t path_len = PATH_DIRS * (sizeof(sandbox) + 8);
+    char *path = malloc(path_len);
+    if (path == NULL) {
+        perror("malloc failed in make_path()");
+        exit(-1);
+    }
+    path[0] = '\0';
+    for (int d = 0; d < PATH_DIRS; d++) {
+        char dir[sizeof(sandbox) + 8];
+        snprintf(dir, sizeof(dir), "%s/d%d", sandbox, d);
+        mkdir(dir, 0755);
+        for (int f = 0; f < PATH_FILES; f++) {
+            char file[sizeof(dir) + 32];
+            snprintf(file, sizeof(file), "%s/cmd%d_%d", dir, d, f);
+            int fd = open(file, O_WRONLY | O_CREAT, 0755);
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        strcat(path, d ? ":" : "");
+        strcat(path, dir);
+    }
+    var_set("PATH", path, true);
+    free(path);
+    return true;
+}
+
+/**
+ * empties and removes the sandbox
+ */
+static void remove_path ()
+{
+    for (int d = 0; d < PATH_DIRS; d++) {
+        char dir[sizeof(sandbox) + 8];
+        snprintf(dir, sizeof(dir), "%s/d%d", sandbox, d);
+        DIR *dp = opendir(dir);
+        struct dirent *ent;
+        while (dp != NULL && (ent = readdir(dp)) != NULL) {
+            if (ent->d_name[0] != '.') {
+                unlinkat(dirfd(dp), ent->d_name, 0);
+            }
+        }
+        if (dp != NULL) {
+            closedir(dp);
+        }
+        rmdir(dir);
+    }
+    rmdir(sandbox);
+}
+
+/**
+ * true if the benchmark called name should run, or for a group of
+ * them if any might
+ */
+static bool wanted (const char *name)
+{
+    if (only == NULL) {
+        return true;
+    }
+    size_t n = strlen(name) < strlen(only) ? strlen(name) : strlen(only);
+    return !strncmp(name, only, n);
+}
+
+/**
+ * the next result, with room for samples times
+ */
+static struct result *new_result (const char *name, const char *unit,
+        int samples)
+{
+    if (result_ct == MAX_RESULTS) {
+        fprintf(stderr, "bench: too many benchmarks\n");
+        exit(-1);
+    }
+    struct result *r = &results[result_ct++];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->unit = unit;
+    r->ns = malloc((samples > 0 ? samples : 1) * sizeof(long long));
+    if (r->ns == NULL) {
+        perror("malloc failed in new_result()");
+        exit(-1);
+    }
+    r->ct = 0;
+    r->cap = samples;
+    r->extra_ct = 0;
+    return r;
+}
+
+/**
+ * true until a result has all the samples it has room for, or has
+ * taken MIN_SAMPLES and used up the time budget since began
+ */
+static bool more_samples (struct result *r, long long began)
+{
+    if (r->ct == r->cap) {
+        return false;
+    }
+    return r->ct < MIN_SAMPLES || monotonic_ns() - began < budget;
+}
+
+/**
+ * a number worth showing next to a benchmark's times
+ */
+static void add_extra (struct result *r, const char *name, double value)
+{
+    if (r->extra_ct < MAX_EXTRA) {
+        r->extra_name[r->extra_ct] = name;
+        r->extra[r->extra_ct++] = value;
+    }
+}
+
+/**
+ * qsort() order for sample times
+ */
+static int by_ns (const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * the pct percentile of a result's samples, nearest rank. the samples
+ * have to be sorted
+ */
+static long long percentile (struct result *r, int pct)
+{
+    if (r->ct == 0) {
+        return 0;
+    }
+    long rank = ((long)r->ct * pct + 99) / 100; // ceiling
+    return r->ns[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * a table of every result, times in ns per unit
+ */
+static void print_table ()
+{
+    printf("%-20s %8s %10s %10s %10s %10s  %s\n", "benchmark", "samples",
+            "p50", "p90", "p99", "max", "ns per / extra");
+    for (int i = 0; i < result_ct; i++) {
+        struct result *r = &results[i];
+        qsort(r->ns, r->ct, sizeof(long long), by_ns);
+        printf("%-20s %8d %10lld %10lld %10lld %10lld  %s", r->name, r->ct,
+                percentile(r, 50), percentile(r, 90), percentile(r, 99),
+                percentile(r, 100), r->unit);
+        for (int e = 0; e < r->extra_ct; e++) {
+            printf("  %s=%.2f", r->extra_name[e], r->extra[e]);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * one JSON object per line per result, the format --baseline reads
+ */
+static void print_json ()
+{
+    for (int i = 0; i < result_ct; i++) {
+        struct result *r = &results[i];
+        qsort(r->ns, r->ct, sizeof(long long), by_ns);
+        long long sum = 0;
+        for (int s = 0; s < r->ct; s++) {
+            sum += r->ns[s];
+        }
+        printf("{\"name\":\"%s\",\"unit\":\"%s\",\"samples\":%d,"
+                "\"mean_ns\":%lld,\"p50_ns\":%lld,\"p90_ns\":%lld,"
+                "\"p99_ns\":%lld,\"max_ns\":%lld", r->name, r->unit, r->ct,
+                r->ct ? sum / r->ct : 0, percentile(r, 50), percentile(r, 90),
+                percentile(r, 99), percentile(r, 100));
+        for (int e = 0; e < r->extra_ct; e++) {
+            printf(",\"%s\":%.3f", r->extra_name[e], r->extra[e]);
+        }
+        printf("}\n");
+    }
+}
+
+/**
+ * compares each result's p50 with the same benchmark's in a file of
+ * --json output. returns 1 if any got more than tolerance percent
+ * slower, so make or CI can fail on it
+ */
+static int check_baseline (const char *file, int tolerance)
+{
+    FILE *fp = fopen(file, "r");
+    if (fp == NULL) {
+        perror(file);
+        return 1;
+    }
+    int slower = 0;
+    char buf[1024];
+    while (fgets(buf, sizeof(buf), fp) != NULL) {
+        char name[48];
+        long long old_p50;
+        char *n = strstr(buf, "\"name\":\"");
+        char *p = strstr(buf, "\"p50_ns\":");
+        if (n == NULL || p == NULL || sscanf(n + 8, "%47[^\"]", name) != 1
+                || sscanf(p + 9, "%lld", &old_p50) != 1) {
+            continue;
+        }
+        for (int i = 0; i < result_ct; i++) {
+            if (strcmp(results[i].name, name)) {
+                continue;
+            }
+            long long p50 = percentile(&results[i], 50);
+            if (p50 * 100 > old_p50 * (100 + tolerance)) {
+                fprintf(stderr, "bench: %s p50 %lld ns, was %lld ns\n",
+                        name, p50, old_p50);
+                slower++;
+            }
+        }
+    }
+    fclose(fp);
+    if (slower) {
+        fprintf(stderr, "bench: %d benchmarks more than %d%% slower\n",
+                slower, tolerance);
+    }
+    return slower ? 1 : 0;
+}
+
+/**
+ * how to run bench
+ */
+static void usage ()
+{
+    fprintf(stderr, "usage: bench [--quick] [--json] [--baseline file"
+            " [--tolerance pct]] [prefix]\n");
+    exit(2);
+}
+
+/* the shell's main loop isn't linked in, these are what the modules
+ * use from it */
+
+void manage_rusage (enum RMANAGE setting, struct rusage usage)
+{
+}
+
+void show_all_resources ()
+{
+}
+
+int last_status ()
+{
+    return 0;
+}
+
+/* malloc, calloc and realloc calls from the shell's code come through
+ * these, the makefile links bench with --wrap for each */
+
+void *__wrap_malloc (size_t size)
+{
+    heap_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc (size_t n, size_t size)
+{
+    heap_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc (void *ptr, size_t size)
+{
+    heap_allocs++;
+    return __real_realloc(ptr, size);
+}
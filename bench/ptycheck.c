@@ -0,0 +1,199 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 ptycheck.c                   *
+ ************************************************
+ * Runs sush on a pseudo terminal, so it has    *
+ * job control, and checks a builtin stage      *
+ * writing more than a pipe holds to a stage    *
+ * that reads the terminal doesn't hang. Run    *
+ * with make ptycheck                           *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define BIG_SIZE 1234567    // what the reader should count
+#define TIMEOUT_MS 5000
+#define OUT_SIZE 65536      // how much of what sush prints is kept
+
+static char big[] = "/tmp/sush-ptycheck-XXXXXX";
+
+static bool make_big ();
+static bool wait_for (int, char *, size_t *, const char *);
+static void send (int, const char *);
+static long long now_ms ();
+
+/**
+ * ptycheck sush
+ * returns 0 if sush passed every check
+ */
+int main (int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: ptycheck sush\n");
+        return 2;
+    }
+    if (!make_big()) {
+        return 2;
+    }
+
+    int master;
+    pid_t pid = forkpty(&master, NULL, NULL, NULL);
+    if (pid < 0) {
+        perror("forkpty failed");
+        unlink(big);
+        return 2;
+    }
+    if (pid == 0) {
+        setenv("PS1", "ptycheck$ ", 1);
+        execl(argv[1], argv[1], (char *)NULL);
+        perror(argv[1]);
+        exit(127);
+    }
+
+    /* the cat runs in the shell or its child, the sh in the job's
+     * group, which only gets to read once it has the terminal. go is
+     * typed once sh says it is about to read, or sush could take it as
+     * its next line. the quotes keep the echo of the line itself from
+     * looking like what sh says */
+    char out[OUT_SIZE];
+    size_t len = 0;
+    bool ok = wait_for(master, out, &len, "ptycheck$ ");
+    if (ok) {
+        char line[256];
+        snprintf(line, sizeof(line), "cat %s | sh -c 'echo rea\"\"dy;"
+                " read x < /dev/tty; echo got $(wc -c)'\n", big);
+        send(master, line);
+        ok = wait_for(master, out, &len, "ready");
+    }
+    if (ok) {
+        send(master, "go\n");
+        char want[64];
+        snprintf(want, sizeof(want), "got %d", BIG_SIZE);
+        ok = wait_for(master, out, &len, want);
+    }
+    if (ok) {
+        send(master, "exit\n");
+    }
+
+    if (ok) {
+        printf("ptycheck: a builtin stage fed a job reading the terminal\n");
+    } else {
+        printf("ptycheck: sush hung on a builtin stage, it printed:\n%.*s\n",
+                (int)len, out);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    close(master);
+    unlink(big);
+    return ok ? 0 : 1;
+}
+
+/**
+ * makes the file the builtin stage copies, bigger than any pipe
+ */
+static bool make_big ()
+{
+    int fd = mkstemp(big);
+    if (fd < 0) {
+        perror("couldn't make the ptycheck file");
+        return false;
+    }
+    char buf[4096];
+    memset(buf, 'x', sizeof(buf));
+    for (int left = BIG_SIZE; left > 0;) {
+        int n = left < (int)sizeof(buf) ? left : (int)sizeof(buf);
+        if (write(fd, buf, n) != n) {
+            perror("couldn't write the ptycheck file");
+            close(fd);
+            unlink(big);
+            return false;
+        }
+        left -= n;
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * reads what the shell prints into out until it has printed want,
+ * after what out already held. false if it doesn't in time. out
+ * keeps only the newest bytes once it fills up
+ */
+static bool wait_for (int fd, char *out, size_t *len, const char *want)
+{
+    size_t from = *len;
+    long long deadline = now_ms() + TIMEOUT_MS;
+    while (true) {
+        out[*len] = '\0';
+        if (strstr(out + from, want) != NULL) {
+            return true;
+        }
+        long long left = deadline - now_ms();
+        if (left <= 0) {
+            return false;
+        }
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        int ready = poll(&p, 1, (int)left);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        if (*len + 1024 >= OUT_SIZE) { // keep the newest half
+            memmove(out, out + OUT_SIZE/2, *len - OUT_SIZE/2);
+            *len -= OUT_SIZE/2;
+            from = from > OUT_SIZE/2 ? from - OUT_SIZE/2 : 0;
+        }
+        ssize_t n = read(fd, out + *len, OUT_SIZE - *len - 1);
+        if (n <= 0) {
+            return false; // the shell went away
+        }
+        *len += n;
+    }
+}
+
+/**
+ * types text into the terminal
+ */
+static void send (int fd, const char *text)
+{
+    size_t len = strlen(text);
+    while (len > 0) {
+        ssize_t n = write(fd, text, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        text += n;
+        len -= n;
+    }
+}
+
+/**
+ * CLOCK_MONOTONIC in ms
+ */
+static long long now_ms ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,726 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                  replay.c                    *
+ ************************************************
+ * Records a session of command lines with the  *
+ * time between them and the environment, then  *
+ * replays it against a sush build, and dash to *
+ * compare with, in a sandbox. Reports wall and *
+ * CPU time, processes started and how long     *
+ * each line took                               *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define LOG_MAGIC "sush-session 1"
+#define MARK "sush-replay-mark"
+
+extern char **environ;
+
+/* one line typed into the session */
+struct rec_line {
+    long long delay_us; // since the line before it
+    char *text;
+};
+
+/* a session as it was recorded */
+struct session {
+    char **env;
+    int env_ct;
+    char *rc;           // the .sushrc it ran with, NULL if none
+    size_t rc_len;
+    struct rec_line *lines;
+    int line_ct;
+};
+
+/* what replaying a session against one shell cost */
+struct run {
+    const char *shell;
+    long long wall_ns;
+    struct rusage ruse;
+    long spawns;
+    long long *line_ns; // -1 for a line that timed out
+    int timeouts;
+};
+
+static int record (const char *, const char *);
+static int play (const char *, const char *, bool, bool, int, int, bool);
+static bool load_session (const char *, struct session *);
+static bool replay (struct session *, const char *, bool, int,
+        struct run *);
+static bool wait_mark (int, int, int);
+static char **sandbox_env (struct session *, const char *);
+static void write_rc (struct session *, const char *);
+static void remove_tree (const char *);
+static long last_pid ();
+static void print_run (struct run *, int, bool);
+static int by_ns (const void *, const void *);
+static void log_escaped (FILE *, const char *, size_t);
+static size_t unescape (char *);
+static void *grow (void *, int *, size_t);
+static long long now_ns ();
+static char *find_in_path (const char *);
+static bool write_all (int, const char *, size_t);
+static void usage ();
+
+/**
+ * replay record [-o log] [-s shell]
+ *     runs shell, ./sush by default, on the lines typed on stdin and
+ *     logs them, with the environment and .sushrc, to log
+ * replay play [-s shell] [-d] [-r] [-n runs] [-t secs] [-j] log
+ *     replays log against shell, and against dash too with -d. -r
+ *     waits between lines as long as the user did. each line has
+ *     secs (default 10) to finish. -j prints JSON
+ */
+int main (int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+    }
+    const char *shell = "./sush";
+    const char *log = NULL;
+    bool dash = false;
+    bool realtime = false;
+    bool json = false;
+    int runs = 1;
+    int timeout = 10;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "o:s:drn:t:j")) != -1) {
+        switch (opt) {
+        case 'o':
+            log = optarg;
+            break;
+        case 's':
+            shell = optarg;
+            break;
+        case 'd':
+            dash = true;
+            break;
+        case 'r':
+            realtime = true;
+            break;
+        case 'n':
+            runs = atoi(optarg) > 0 ? atoi(optarg) : 1;
+            break;
+        case 't':
+            timeout = atoi(optarg) > 0 ? atoi(optarg) : 10;
+            break;
+        case 'j':
+            json = true;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if (!strcmp(argv[1], "record")) {
+        return record(log ? log : "session.log", shell);
+    }
+    if (!strcmp(argv[1], "play") && optind == argc - 1) {
+        return play(argv[optind], shell, dash, realtime, runs, timeout, json);
+    }
+    usage();
+    return 2;
+}
+
+/**
+ * passes the lines on stdin to a shell, logging each as it arrives.
+ * the shell's output goes where ours does
+ */
+static int record (const char *log, const char *shell)
+{
+    FILE *out = fopen(log, "w");
+    if (out == NULL) {
+        perror(log);
+        return 1;
+    }
+    fprintf(out, "%s\n", LOG_MAGIC);
+    for (char **env = environ; *env != NULL; env++) {
+        fputs("e ", out);
+        log_escaped(out, *env, strlen(*env));
+        fputc('\n', out);
+    }
+    const char *home = getenv("HOME");
+    if (home != NULL) {
+        char rc[PATH_MAX];
+        snprintf(rc, sizeof(rc), "%s/.sushrc", home);
+        FILE *fp = fopen(rc, "r");
+        char *line = NULL;
+        size_t cap = 0;
+        ssize_t len;
+        while (fp != NULL && (len = getline(&line, &cap, fp)) > 0) {
+            fputs("r ", out);
+            log_escaped(out, line, line[len-1] == '\n' ? len - 1 : len);
+            fputc('\n', out);
+        }
+        free(line);
+        if (fp != NULL) {
+            fclose(fp);
+        }
+    }
+
+    int to_shell[2];
+    if (pipe(to_shell) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    } else if (pid == 0) {
+        dup2(to_shell[0], STDIN_FILENO);
+        close(to_shell[0]);
+        close(to_shell[1]);
+        execl(shell, shell, (char *)NULL);
+        perror(shell);
+        exit(127);
+    }
+    close(to_shell[0]);
+    signal(SIGPIPE, SIG_IGN); // the shell exiting ends the session
+
+    /* lines are logged when they arrive, which for a terminal is when
+     * return was pressed */
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    long long last = now_ns();
+    while ((len = getline(&line, &cap, stdin)) > 0) {
+        long long now = now_ns();
+        fprintf(out, "l %lld ", (now - last) / 1000);
+        log_escaped(out, line, line[len-1] == '\n' ? len - 1 : len);
+        fputc('\n', out);
+        last = now;
+        if (line[len-1] != '\n') {
+            line[len++] = '\n'; // getline left room for the NUL
+        }
+        if (!write_all(to_shell[1], line, len)) {
+            break;
+        }
+    }
+    free(line);
+    close(to_shell[1]);
+    int status;
+    waitpid(pid, &status, 0);
+    fclose(out);
+    return 0;
+}
+
+/**
+ * replays a logged session runs times against shell, and dash if
+ * asked, and prints what each run cost
+ */
+static int play (const char *log, const char *shell, bool dash,
+        bool realtime, int runs, int timeout, bool json)
+{
+    struct session s;
+    if (!load_session(log, &s)) {
+        return 1;
+    }
+    char *shells[2] = { realpath(shell, NULL), NULL };
+    if (shells[0] == NULL) {
+        perror(shell);
+        return 1;
+    }
+    if (dash) {
+        shells[1] = find_in_path("dash");
+        if (shells[1] == NULL) {
+            fprintf(stderr, "replay: no dash in $PATH, skipping it\n");
+        }
+    }
+
+    int err = 0;
+    for (int sh = 0; sh < 2; sh++) {
+        for (int i = 0; shells[sh] != NULL && i < runs; i++) {
+            struct run r;
+            if (!replay(&s, shells[sh], realtime, timeout, &r)) {
+                err = 1;
+                continue;
+            }
+            print_run(&r, s.line_ct, json);
+            free(r.line_ns);
+        }
+    }
+    free(shells[0]);
+    free(shells[1]);
+    return err;
+}
+
+/**
+ * reads a session log. returns false if it isn't one
+ */
+static bool load_session (const char *log, struct session *s)
+{
+    memset(s, 0, sizeof(struct session));
+    FILE *fp = fopen(log, "r");
+    if (fp == NULL) {
+        perror(log);
+        return false;
+    }
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len = getline(&line, &cap, fp);
+    if (len <= 0 || strncmp(line, LOG_MAGIC, strlen(LOG_MAGIC))) {
+        fprintf(stderr, "replay: %s isn't a session log\n", log);
+        fclose(fp);
+        free(line);
+        return false;
+    }
+
+    int env_cap = 0;
+    int line_cap = 0;
+    while ((len = getline(&line, &cap, fp)) > 0) {
+        if (line[len-1] == '\n') {
+            line[--len] = '\0';
+        }
+        if (len < 2 || line[1] != ' ') {
+            continue;
+        }
+        char *text = line + 2;
+        if (line[0] == 'e') {
+            if (s->env_ct + 1 >= env_cap) {
+                s->env = grow(s->env, &env_cap, sizeof(char *));
+            }
+            unescape(text);
+            s->env[s->env_ct++] = strdup(text);
+        } else if (line[0] == 'r') {
+            size_t n = unescape(text);
+            s->rc = realloc(s->rc, s->rc_len + n + 1);
+            if (s->rc == NULL) {
+                perror("realloc failed in load_session()");
+                exit(-1);
+            }
+            memcpy(s->rc + s->rc_len, text, n);
+            s->rc_len += n;
+            s->rc[s->rc_len++] = '\n';
+        } else if (line[0] == 'l') {
+            char *rest;
+            long long delay = strtoll(text, &rest, 10);
+            if (*rest == ' ') {
+                rest++;
+            }
+            unescape(rest);
+            if (s->line_ct == line_cap) {
+                s->lines = grow(s->lines, &line_cap, sizeof(struct rec_line));
+            }
+            s->lines[s->line_ct].delay_us = delay;
+            s->lines[s->line_ct++].text = strdup(rest);
+        }
+    }
+    free(line);
+    fclose(fp);
+    return true;
+}
+
+/**
+ * runs one shell in a fresh sandbox dir, with the recorded .sushrc
+ * in HOME and the recorded environment. each line is followed by an
+ * echo of a numbered mark, and it counts as done when the mark comes
+ * back. returns false if the shell couldn't be started
+ */
+static bool replay (struct session *s, const char *shell, bool realtime,
+        int timeout, struct run *r)
+{
+    char sandbox[] = "/tmp/sush-replay-XXXXXX";
+    if (mkdtemp(sandbox) == NULL) {
+        perror("replay: mkdtemp");
+        return false;
+    }
+    write_rc(s, sandbox);
+    char **envp = sandbox_env(s, sandbox);
+
+    int to_shell[2];
+    int from_shell[2];
+    if (pipe2(to_shell, O_CLOEXEC) < 0 || pipe2(from_shell, O_CLOEXEC) < 0) {
+        perror("pipe");
+        return false;
+    }
+    memset(r, 0, sizeof(struct run));
+    r->shell = shell;
+    r->line_ns = calloc(s->line_ct + 1, sizeof(long long));
+    if (r->line_ns == NULL) {
+        perror("calloc failed in replay()");
+        exit(-1);
+    }
+
+    long pid_before = last_pid();
+    long long start = now_ns();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    } else if (pid == 0) {
+        dup2(to_shell[0], STDIN_FILENO);
+        dup2(from_shell[1], STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDERR_FILENO);
+        if (chdir(sandbox) < 0) {
+            exit(127);
+        }
+        execle(shell, shell, (char *)NULL, envp);
+        exit(127);
+    }
+    close(to_shell[0]);
+    close(from_shell[1]);
+    signal(SIGPIPE, SIG_IGN);
+
+    long long due = start;
+    for (int i = 0; i < s->line_ct; i++) {
+        if (realtime) {
+            due += s->lines[i].delay_us * 1000;
+            long long wait = due - now_ns();
+            if (wait > 0) {
+                struct timespec ts = { wait / 1000000000, wait % 1000000000 };
+                nanosleep(&ts, NULL);
+            }
+        }
+        size_t len = strlen(s->lines[i].text);
+        char buf[len + 64];
+        int n = snprintf(buf, sizeof(buf), "%s\necho %s-%d\n",
+                s->lines[i].text, MARK, i);
+        long long sent = now_ns();
+        if (!write_all(to_shell[1], buf, n)) {
+            for (; i < s->line_ct; i++) {
+                r->line_ns[i] = -1; // the shell has exited
+                r->timeouts++;
+            }
+            break;
+        }
+        if (wait_mark(from_shell[0], i, timeout)) {
+            r->line_ns[i] = now_ns() - sent;
+        } else {
+            r->line_ns[i] = -1;
+            r->timeouts++;
+        }
+    }
+
+    /* let it finish up and exit on its own */
+    close(to_shell[1]);
+    char drain[4096];
+    while (read(from_shell[0], drain, sizeof(drain)) > 0) {
+        ;
+    }
+    close(from_shell[0]);
+    int status;
+    wait4(pid, &status, 0, &r->ruse);
+    r->wall_ns = now_ns() - start;
+    long pid_after = last_pid();
+    r->spawns = pid_before < 0 || pid_after < 0 ? -1
+        : pid_after - pid_before - 1; // not counting the shell
+
+    for (int i = 0; envp[i] != NULL; i++) {
+        free(envp[i]);
+    }
+    free(envp);
+    remove_tree(sandbox);
+    return true;
+}
+
+/**
+ * reads the shell's output until the mark for line n shows up.
+ * returns false if it doesn't within timeout seconds or the shell
+ * exits first
+ */
+static bool wait_mark (int fd, int n, int timeout)
+{
+    char needle[64];
+    int needle_len = snprintf(needle, sizeof(needle), "%s-%d\n", MARK, n);
+    char buf[8192 + 64];
+    int kept = 0; // end of the last read, in case the mark was split
+    long long deadline = now_ns() + timeout * 1000000000LL;
+    while (true) {
+        long long left = (deadline - now_ns()) / 1000000;
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (left <= 0 || poll(&pfd, 1, left) == 0) {
+            return false;
+        }
+        ssize_t got = read(fd, buf + kept, sizeof(buf) - 64);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        int len = kept + got;
+        if (memmem(buf, len, needle, needle_len) != NULL) {
+            return true;
+        }
+        kept = len < needle_len ? len : needle_len - 1;
+        memmove(buf, buf + len - kept, kept);
+    }
+}
+
+/**
+ * the recorded environment with HOME and PWD pointed at the sandbox,
+ * so read_sushrc() finds the recorded .sushrc and nothing the user
+ * has outside it
+ */
+static char **sandbox_env (struct session *s, const char *sandbox)
+{
+    char **envp = calloc(s->env_ct + 3, sizeof(char *));
+    if (envp == NULL) {
+        perror("calloc failed in sandbox_env()");
+        exit(-1);
+    }
+    int ct = 0;
+    for (int i = 0; i < s->env_ct; i++) {
+        if (strncmp(s->env[i], "HOME=", 5) && strncmp(s->env[i], "PWD=", 4)
+                && strncmp(s->env[i], "XDG_CACHE_HOME=", 15)) {
+            envp[ct++] = strdup(s->env[i]);
+        }
+    }
+    asprintf(&envp[ct++], "HOME=%s", sandbox);
+    asprintf(&envp[ct++], "PWD=%s", sandbox);
+    return envp;
+}
+
+/**
+ * puts the recorded .sushrc in the sandbox
+ */
+static void write_rc (struct session *s, const char *sandbox)
+{
+    if (s->rc == NULL) {
+        return;
+    }
+    char rc[PATH_MAX];
+    snprintf(rc, sizeof(rc), "%s/.sushrc", sandbox);
+    int fd = open(rc, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || !write_all(fd, s->rc, s->rc_len)) {
+        perror(rc);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * removes a sandbox and everything the session left in it
+ */
+static void remove_tree (const char *path)
+{
+    DIR *dp = opendir(path);
+    struct dirent *ent;
+    while (dp != NULL && (ent = readdir(dp)) != NULL) {
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) {
+            continue;
+        }
+        char child[PATH_MAX];
+        snprintf(child, sizeof(child), "%s/%s", path, ent->d_name);
+        if (ent->d_type == DT_DIR) {
+            remove_tree(child);
+        } else {
+            unlink(child);
+        }
+    }
+    if (dp != NULL) {
+        closedir(dp);
+    }
+    rmdir(path);
+}
+
+/**
+ * the last pid the kernel handed out, from /proc/loadavg. the
+ * difference across a run is how many processes and threads were
+ * started, by anything, so it's exact only on a quiet machine
+ */
+static long last_pid ()
+{
+    FILE *fp = fopen("/proc/loadavg", "r");
+    long pid = -1;
+    if (fp != NULL) {
+        if (fscanf(fp, "%*s %*s %*s %*s %ld", &pid) != 1) {
+            pid = -1;
+        }
+        fclose(fp);
+    }
+    return pid;
+}
+
+/**
+ * one line of results for a run, times in microseconds
+ */
+static void print_run (struct run *r, int line_ct, bool json)
+{
+    static bool header = false;
+    long long *done = malloc((line_ct + 1) * sizeof(long long));
+    if (done == NULL) {
+        perror("malloc failed in print_run()");
+        exit(-1);
+    }
+    int ct = 0;
+    for (int i = 0; i < line_ct; i++) {
+        if (r->line_ns[i] >= 0) {
+            done[ct++] = r->line_ns[i];
+        }
+    }
+    qsort(done, ct, sizeof(long long), by_ns);
+    long long pct[4] = { 50, 90, 99, 100 };
+    for (int p = 0; p < 4; p++) {
+        long rank = (ct * pct[p] + 99) / 100;
+        pct[p] = ct ? done[rank > 0 ? rank - 1 : 0] / 1000 : 0;
+    }
+    free(done);
+
+    double wall = r->wall_ns / 1e9;
+    double user = r->ruse.ru_utime.tv_sec + r->ruse.ru_utime.tv_usec / 1e6;
+    double sys = r->ruse.ru_stime.tv_sec + r->ruse.ru_stime.tv_usec / 1e6;
+    if (json) {
+        printf("{\"shell\":\"%s\",\"lines\":%d,\"wall\":%.6f,\"user\":%.6f,"
+                "\"sys\":%.6f,\"spawns\":%ld,\"p50_us\":%lld,\"p90_us\":%lld,"
+                "\"p99_us\":%lld,\"max_us\":%lld,\"timeouts\":%d}\n",
+                r->shell, line_ct, wall, user, sys, r->spawns, pct[0], pct[1],
+                pct[2], pct[3], r->timeouts);
+        return;
+    }
+    if (!header) {
+        printf("%-24s %6s %9s %9s %9s %7s %9s %9s %9s %9s %8s\n", "shell",
+                "lines", "wall", "user", "sys", "spawns", "p50_us", "p90_us",
+                "p99_us", "max_us", "timeouts");
+        header = true;
+    }
+    printf("%-24s %6d %9.4f %9.4f %9.4f %7ld %9lld %9lld %9lld %9lld %8d\n",
+            r->shell, line_ct, wall, user, sys, r->spawns, pct[0], pct[1],
+            pct[2], pct[3], r->timeouts);
+}
+
+/**
+ * qsort() order for line times
+ */
+static int by_ns (const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * writes len bytes of s to a log so they stay on one line.
+ * backslashes and control characters become \\ and \xHH
+ */
+static void log_escaped (FILE *out, const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = s[i];
+        if (c == '\\') {
+            fputs("\\\\", out);
+        } else if (c < 0x20 || c == 0x7f) {
+            fprintf(out, "\\x%02x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+}
+
+/**
+ * undoes log_escaped() in place. returns the new length
+ */
+static size_t unescape (char *s)
+{
+    char *out = s;
+    for (char *c = s; *c; c++) {
+        if (c[0] == '\\' && c[1] == '\\') {
+            *out++ = '\\';
+            c++;
+        } else if (c[0] == '\\' && c[1] == 'x' && c[2] && c[3]) {
+            char hex[3] = { c[2], c[3], '\0' };
+            *out++ = (char)strtol(hex, NULL, 16);
+            c += 3;
+        } else {
+            *out++ = *c;
+        }
+    }
+    *out = '\0';
+    return out - s;
+}
+
+/**
+ * doubles an array's capacity
+ */
+static void *grow (void *arr, int *cap, size_t size)
+{
+    *cap = *cap ? *cap * 2 : 64;
+    arr = realloc(arr, *cap * size);
+    if (arr == NULL) {
+        perror("realloc failed in grow()");
+        exit(-1);
+    }
+    return arr;
+}
+
+/**
+ * CLOCK_MONOTONIC in nanoseconds
+ */
+static long long now_ns ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * the full path of name in $PATH, which the caller frees, or NULL
+ */
+static char *find_in_path (const char *name)
+{
+    const char *path = getenv("PATH");
+    while (path != NULL && *path) {
+        const char *end = strchrnul(path, ':');
+        char file[PATH_MAX];
+        snprintf(file, sizeof(file), "%.*s/%s", (int)(end - path), path, name);
+        if (access(file, X_OK) == 0) {
+            return strdup(file);
+        }
+        path = *end ? end + 1 : end;
+    }
+    return NULL;
+}
+
+/**
+ * writes all of buf to fd. returns false if fd was closed
+ */
+static bool write_all (int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * how to run replay
+ */
+static void usage ()
+{
+    fprintf(stderr, "usage: replay record [-o log] [-s shell]\n"
+            "       replay play [-s shell] [-d] [-r] [-n runs] [-t secs]"
+            " [-j] log\n");
+    exit(2);
+}
@@ -0,0 +1,92 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 tokbase.c                    *
+ ************************************************
+ * Prints the tokens the original tokenize()    *
+ * makes of every line of a corpus, in the same *
+ * form as tokcheck --base. make tokbase builds *
+ * it against the tokenizer of the first commit *
+ * so the expected tokens of the shared corpus  *
+ * can be checked to really be what the old     *
+ * tokenizer did                                *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include "tokenizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_str (const char *);
+
+/**
+ * tokbase corpus
+ * tokenizes each line of corpus on its own, the only way the old
+ * tokenizer could, and prints what it made of it
+ */
+int main (int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: tokbase corpus\n");
+        return 2;
+    }
+    FILE *fp = fopen(argv[1], "r");
+    if (fp == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+    /* bad lines are part of the corpus, what they say doesn't matter */
+    if (freopen("/dev/null", "w", stderr) == NULL) {
+        perror("couldn't quiet stderr");
+    }
+
+    struct tok_list tlist = { NULL, NULL, 0, 0 };
+    char *line = NULL;
+    size_t cap = 0;
+    int lineno = 0;
+    while (getline(&line, &cap, fp) > 0) {
+        lineno++;
+        tokenize(&tlist, line);
+        if (tlist.count == 0) {
+            printf("line %d: none\n", lineno);
+            continue;
+        }
+        printf("line %d:\n", lineno);
+        for (tok_node *t = tlist.head; t != NULL; t = t->next) {
+            printf("\t%s ", t->special ? "special" : "word");
+            print_str(t->token);
+            putchar('\n');
+        }
+        free_tok_list(&tlist);
+    }
+    free(line);
+    fclose(fp);
+    return 0;
+}
+
+/**
+ * prints a token the way tokcheck does
+ */
+static void print_str (const char *s)
+{
+    putchar('[');
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '\n') {
+            fputs("\\n", stdout);
+        } else if (c == '\t') {
+            fputs("\\t", stdout);
+        } else if (c == '\\') {
+            fputs("\\\\", stdout);
+        } else if (c < 32 || c > 126) {
+            printf("\\x%02x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar(']');
+}
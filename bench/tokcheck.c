@@ -0,0 +1,383 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 tokcheck.c                   *
+ ************************************************
+ * Tokenizes the lines of a corpus and checks   *
+ * the tokens against what they are expected    *
+ * to be. The corpus is fed whole and in small  *
+ * chunks so lines are also split at every      *
+ * place a read() could split them. Built once  *
+ * for each scan_plain() path by make tokcheck. *
+ * --base prints only what the original         *
+ * tokenizer had, to check against tokbase      *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include "../includes/sush.h"
+#include "../includes/tokenizer.h"
+#include "../includes/vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#if defined(__AVX2__)
+#define SCAN_PATH "avx2"
+#elif defined(__SSE2__)
+#define SCAN_PATH "sse2"
+#else
+#define SCAN_PATH "scalar"
+#endif
+
+/* how much of the corpus is fed to tokenize_chunk() at once, 0 is all
+ * of it. the odd sizes split lines inside words, quotes and $NAMEs */
+static const int chunk_sizes[] = { 0, 1, 2, 3, 5, 16, 31, 33, 4096 };
+
+/* files made in the dir the corpus is tokenized in so wildcards
+ * always match the same things */
+static const char *files[] = {
+    "alpha.c", "beta.c", "gamma.h", ".hidden.c", "sub/one.c", "sub/two.h"
+};
+
+static char sandbox[] = "/tmp/sush-tokcheck-XXXXXX";
+static bool base = false; // print tokens the way tokbase does
+
+static char *read_file (const char *, size_t *);
+static char *run_corpus (const char *, size_t, int, size_t *);
+static void print_line (FILE *, struct tok_list *, int);
+static void print_error (FILE *, int);
+static void print_str (FILE *, const char *);
+static bool compare (const char *, size_t, const char *, size_t, int);
+static void make_sandbox ();
+static void remove_sandbox ();
+static void usage ();
+
+/**
+ * tokcheck [--base] corpus [expected]
+ * prints the tokens of every line of corpus, or with expected checks
+ * they are the same as in that file for every chunk size. returns 0
+ * if they all match
+ */
+int main (int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "--base")) {
+        base = true;
+        argc--;
+        argv++;
+    }
+    if (argc < 2 || argc > 3) {
+        usage();
+    }
+#if defined(__AVX2__)
+    if (!__builtin_cpu_supports("avx2")) {
+        printf("tokcheck (" SCAN_PATH "): skipped, no AVX2 on this CPU\n");
+        return 0;
+    }
+#endif
+
+    size_t corpus_len;
+    char *corpus = read_file(argv[1], &corpus_len);
+    size_t expected_len = 0;
+    char *expected = argc == 3 ? read_file(argv[2], &expected_len) : NULL;
+
+    /* the variables the corpus uses */
+    var_set("V", "value", false);
+    var_set("EMPTY", "", false);
+    var_set("SPACED", "two words", false);
+    var_set("STAR", "*.c", false);
+    var_set("LONG", "0123456789abcdefghijklmnopqrstuvwxyz"
+            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ", false);
+
+    /* bad lines are part of the corpus, what they say doesn't matter */
+    if (freopen("/dev/null", "w", stderr) == NULL) {
+        perror("couldn't quiet stderr");
+    }
+    make_sandbox();
+
+    int status = 0;
+    int size_ct = sizeof(chunk_sizes) / sizeof(chunk_sizes[0]);
+    for (int i = 0; i < size_ct; i++) {
+        size_t out_len;
+        char *out = run_corpus(corpus, corpus_len, chunk_sizes[i], &out_len);
+        if (expected == NULL) {
+            fwrite(out, 1, out_len, stdout);
+            free(out);
+            break;
+        }
+        if (!compare(out, out_len, expected, expected_len, chunk_sizes[i])) {
+            status = 1;
+        }
+        free(out);
+    }
+    if (expected != NULL && status == 0) {
+        printf("tokcheck (" SCAN_PATH "): %s matches at %d chunk sizes\n",
+                argv[1], size_ct);
+    }
+
+    remove_sandbox();
+    free(corpus);
+    free(expected);
+    return status;
+}
+
+/**
+ * reads a whole file into memory
+ */
+static char *read_file (const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror(path);
+        exit(2);
+    }
+    size_t cap = 65536;
+    char *buf = malloc(cap);
+    if (buf == NULL) {
+        perror("malloc failed in read_file()");
+        exit(-1);
+    }
+    size_t n;
+    *len = 0;
+    while ((n = fread(buf + *len, 1, cap - *len, fp)) > 0) {
+        *len += n;
+        if (*len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+            if (buf == NULL) {
+                perror("realloc failed in read_file()");
+                exit(-1);
+            }
+        }
+    }
+    fclose(fp);
+    return buf;
+}
+
+/**
+ * tokenizes the corpus chunk bytes at a time the way run_input() does
+ * with what read() returns, and returns what print_line() printed
+ * for every line
+ */
+static char *run_corpus (const char *corpus, size_t len, int chunk,
+        size_t *out_len)
+{
+    char *out;
+    FILE *fp = open_memstream(&out, out_len);
+    if (fp == NULL) {
+        perror("open_memstream failed in run_corpus()");
+        exit(-1);
+    }
+    struct tok_list tlist;
+    init_tok_list(&tlist);
+
+    int lineno = 1; // corpus line being read
+    int start = 1;  // line the tokenized line started on
+    for (size_t pos = 0; pos < len;) {
+        int piece = chunk > 0 && len - pos > (size_t)chunk ? chunk
+            : (int)(len - pos);
+        for (int off = 0, used = 0; off < piece; off += used) {
+            enum TOK_STATUS ret = tokenize_chunk(&tlist, corpus + pos + off,
+                    piece - off, &used);
+            for (int i = 0; i < used; i++) {
+                lineno += corpus[pos + off + i] == '\n';
+            }
+            if (ret == TOK_ERROR) {
+                print_error(fp, start);
+            } else if (ret == TOK_DONE) {
+                print_line(fp, &tlist, start);
+                free_tok_list(&tlist);
+            }
+            if (ret != TOK_MORE) {
+                start = lineno;
+            }
+        }
+        pos += piece;
+    }
+    /* a last line with no newline, or one still open at the end */
+    enum TOK_STATUS ret = tokenize_pending(&tlist) ? tokenize_end(&tlist)
+        : TOK_MORE;
+    if (ret == TOK_ERROR) {
+        print_error(fp, start);
+    } else if (ret == TOK_DONE) {
+        print_line(fp, &tlist, start);
+    }
+
+    destroy_tok_list(&tlist);
+    fclose(fp);
+    return out;
+}
+
+/**
+ * prints the tokens of one finished line, one to a line with its kind,
+ * after how many commands and words the line was split into and
+ * whether it had anything expanded, which a pattern that matched
+ * nothing doesn't otherwise show
+ */
+static void print_line (FILE *fp, struct tok_list *tlist, int lineno)
+{
+    static const char *kinds[] = {
+        "word", "pipe", "out", "append", "in", "heredoc", "herestr", "bg"
+    };
+    if (base) {
+        /* the old tokenizer only knew words and special tokens */
+        if (tlist->count == 0) {
+            print_error(fp, lineno);
+            return;
+        }
+        fprintf(fp, "line %d:\n", lineno);
+        for (int i = 0; i < tlist->count; i++) {
+            fprintf(fp, "\t%s ", tlist->toks[i].kind == TOK_WORD ? "word"
+                    : "special");
+            print_str(fp, tlist->toks[i].str);
+            fputc('\n', fp);
+        }
+        return;
+    }
+    if (tlist->count == 0) {
+        return; // blank lines only keep the corpus readable
+    }
+    fprintf(fp, "line %d: %d cmds %d args%s%s\n", lineno, tlist->cmd_ct,
+            tlist->argv_ct, tlist->background ? " bg" : "",
+            tlist->expanded ? " expanded" : "");
+    for (int i = 0; i < tlist->count; i++) {
+        fprintf(fp, "\t%s ", kinds[tlist->toks[i].kind]);
+        print_str(fp, tlist->toks[i].str);
+        fputc('\n', fp);
+    }
+}
+
+/**
+ * prints that a line was thrown away. the old tokenizer left an
+ * empty list for those, the same as for a blank line
+ */
+static void print_error (FILE *fp, int lineno)
+{
+    fprintf(fp, base ? "line %d: none\n" : "line %d: error\n", lineno);
+}
+
+/**
+ * prints a token in brackets with anything that isn't printable
+ * written as an escape, so every token fits on one line
+ */
+static void print_str (FILE *fp, const char *s)
+{
+    fputc('[', fp);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '\n') {
+            fputs("\\n", fp);
+        } else if (c == '\t') {
+            fputs("\\t", fp);
+        } else if (c == '\\') {
+            fputs("\\\\", fp);
+        } else if (c < 32 || c > 126) {
+            fprintf(fp, "\\x%02x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc(']', fp);
+}
+
+/**
+ * says where out first differs from expected, if it does
+ */
+static bool compare (const char *out, size_t out_len, const char *expected,
+        size_t expected_len, int chunk)
+{
+    size_t i = 0;
+    int line = 1;
+    size_t line_start = 0;
+    while (i < out_len && i < expected_len && out[i] == expected[i]) {
+        if (out[i] == '\n') {
+            line++;
+            line_start = i + 1;
+        }
+        i++;
+    }
+    if (i == out_len && i == expected_len) {
+        return true;
+    }
+
+    const char *got = out + line_start;
+    const char *want = expected + line_start;
+    int got_len = (int)strcspn(got, "\n");
+    int want_len = (int)strcspn(want, "\n");
+    if (line_start + got_len > out_len) {
+        got_len = out_len - line_start;
+    }
+    if (line_start + want_len > expected_len) {
+        want_len = expected_len - line_start;
+    }
+    printf("tokcheck (" SCAN_PATH "): chunks of %d differ at output line %d\n"
+            "  expected: %.*s\n  got:      %.*s\n",
+            chunk, line, want_len, want, got_len, got);
+    return false;
+}
+
+/**
+ * makes an empty dir with a few files in it and moves into it
+ */
+static void make_sandbox ()
+{
+    if (mkdtemp(sandbox) == NULL || chdir(sandbox) < 0) {
+        perror("couldn't make the tokcheck sandbox");
+        exit(2);
+    }
+    mkdir("sub", 0755);
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        int fd = open(files[i], O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror(files[i]);
+            exit(2);
+        }
+        close(fd);
+    }
+}
+
+/**
+ * removes what make_sandbox() made
+ */
+static void remove_sandbox ()
+{
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        unlink(files[i]);
+    }
+    rmdir("sub");
+    if (chdir("/") == 0) {
+        rmdir(sandbox);
+    }
+}
+
+/**
+ * how to use tokcheck
+ */
+static void usage ()
+{
+    fprintf(stderr, "usage: tokcheck [--base] corpus [expected]\n");
+    exit(2);
+}
+
+/* the shell's main loop isn't linked in, these are what the modules
+ * use from it */
+
+void manage_rusage (enum RMANAGE setting, struct rusage usage)
+{
+}
+
+void show_all_resources ()
+{
+}
+
+int last_status ()
+{
+    return 0;
+}
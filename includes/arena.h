@@ -0,0 +1,47 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#ifndef ARENA_CHUNK
+#define ARENA_CHUNK 4096
+#endif
+
+#ifndef ARENA_RETAIN
+#define ARENA_RETAIN (1024*1024)
+#endif
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+} arena_chunk;
+
+struct arena {
+    arena_chunk *head; // first chunk, kept across resets
+    arena_chunk *curr; // chunk currently being bumped
+    size_t retain;     // most bytes worth of chunks kept by a reset
+};
+
+struct arena_stats {
+    unsigned long allocs;  // arena_alloc() calls
+    unsigned long mallocs; // chunks malloc'd
+    unsigned long frees;   // chunks free'd
+    unsigned long resets;
+    size_t high_water;     // most bytes handed out between resets
+};
+
+void arena_init (struct arena *, size_t);
+
+void *arena_alloc (struct arena *, size_t);
+
+char *arena_strdup (struct arena *, const char *);
+
+void arena_reset (struct arena *);
+
+void arena_free (struct arena *);
+
+void arena_get_stats (struct arena_stats *);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include "tokenizer.h"
+#include <stdbool.h>
+
+enum BUILTIN_FLAG {
+    BI_SHELL = 1    // can run in the shell itself, even as a pipeline stage
+};
+
+struct sush_builtin;
+
+/* a builtin in the registry. a stage builtin has run, which returns
+ * an exit status and writes to stdout wherever the stage's output
+ * goes. a line builtin has line instead, which changes the shell and
+ * so only runs as the whole line, returning true on error */
+struct builtin {
+    const char *name;
+    int (*run) (int, char **);
+    bool (*line) (int, char **);
+    int flags;
+    unsigned long uses;
+    const struct sush_builtin *loaded; // from enable -f, run instead
+    void *handle;                      // its dlopen() handle
+    char *path;                        // and where it came from
+};
+
+struct builtin *find_builtin (const char *);
+
+void add_builtin (const char *, int (*) (int, char **),
+        bool (*) (int, char **), int);
+
+int run_builtin (struct builtin *, struct tok_list *, int);
+
+bool enable_cmd (int, char **);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef CMDHASH_H
+#define CMDHASH_H
+
+#include <stdbool.h>
+
+const char *cmd_lookup (const char *);
+
+void cmd_hash_set (const char *, const char *);
+
+void cmd_hash_forget ();
+
+void cmd_hash_new_line ();
+
+void cmd_hash_print (bool);
+
+#endif
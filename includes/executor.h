@@ -2,7 +2,13 @@
 #define EXECUTOR_H
 
 #include "tokenizer.h"
+#include <stdbool.h>
+#include <sys/types.h>
 
-void execute (struct tok_list *);
+int execute (struct tok_list *);
+
+pid_t spawn_argv (char **, int, int, int);
+
+bool builtin_interrupted ();
 
 #endif
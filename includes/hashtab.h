@@ -0,0 +1,33 @@
+#ifndef HASHTAB_H
+#define HASHTAB_H
+
+#include <stdbool.h>
+
+typedef struct hash_node {
+    char *key;
+    void *value;
+    unsigned int hash;
+    struct hash_node *next;
+} hash_node;
+
+struct hash_table {
+    hash_node **buckets;
+    int size;
+    int count;
+};
+
+void ht_init (struct hash_table *, int);
+
+void *ht_get (struct hash_table *, const char *);
+
+hash_node *ht_find (struct hash_table *, const char *);
+
+hash_node *ht_put (struct hash_table *, const char *, void *);
+
+void *ht_remove (struct hash_table *, const char *);
+
+void ht_clear (struct hash_table *, void (*)(void *));
+
+void ht_foreach (struct hash_table *, void (*)(hash_node *, void *), void *);
+
+#endif
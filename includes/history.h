@@ -0,0 +1,13 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+void history_collect (const char *, size_t);
+
+void history_end_line ();
+
+bool history_cmd (int, char **);
+
+#endif
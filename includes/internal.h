@@ -5,4 +5,6 @@
 
 int run_internal_cmd (struct tok_list *);
 
+void register_internal_cmds ();
+
 #endif
@@ -0,0 +1,36 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "tokenizer.h"
+#include <stdbool.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+void jobs_init (bool);
+
+bool job_control ();
+
+const sigset_t *jobs_child_mask ();
+
+int jobs_launch (struct tok_list *, pid_t *, int, pid_t, long long, int);
+
+bool jobs_child_changed (pid_t, int, struct rusage *);
+
+bool jobs_reap ();
+
+bool jobs_wait_input (int);
+
+void jobs_notify ();
+
+int exit_status (int);
+
+bool jobs_cmd (int, char **);
+
+bool fg_cmd (int, char **);
+
+bool bg_cmd (int, char **);
+
+bool wait_cmd (int, char **);
+
+#endif
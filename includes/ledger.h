@@ -0,0 +1,20 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+enum LEDGER_FORMAT {
+    LEDGER_TEXT,
+    LEDGER_JSON,
+    LEDGER_CSV
+};
+
+int ledger_new_line ();
+
+void ledger_add (int, int, const char *, pid_t, long long, long long, int,
+        struct rusage *);
+
+void ledger_print (enum LEDGER_FORMAT);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdbool.h>
+
+enum SUSH_OPT {
+    OPT_SPAWN,
+    OPT_PIPESIZE,   // bytes for each pipe of a line, 0 for the default
+    OPT_GLOBTHREADS, // threads walking a **, 0 for one per CPU
+    OPT_COUNT
+};
+
+enum SPAWN_MODE {
+    SPAWN_FORK,
+    SPAWN_POSIX
+};
+
+long get_option (enum SUSH_OPT);
+
+bool set_option (const char *, const char *);
+
+void print_options ();
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+int parallel_cmd (int, char **);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+
+void profile_enable ();
+
+bool profile_enabled ();
+
+long long profile_now ();
+
+void profile_report (const char *, long long, const char *, ...);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef RCCACHE_H
+#define RCCACHE_H
+
+#include "tokenizer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+#define RC_CACHE_VERSION 4
+
+/* compiled form of a .sushrc, built while the file is parsed */
+struct rc_cache {
+    char *data;
+    size_t len;
+    size_t cap;
+    unsigned int records;
+};
+
+bool rc_cache_run (const char *, struct stat *,
+        void (*)(struct tok_list *, int));
+
+void rc_cache_init (struct rc_cache *);
+
+void rc_cache_add_tokens (struct rc_cache *, struct tok_list *, int);
+
+void rc_cache_add_raw (struct rc_cache *, const char *, int, int);
+
+void rc_cache_write (struct rc_cache *, const char *, struct stat *);
+
+void rc_cache_free (struct rc_cache *);
+
+#endif
@@ -5,6 +5,10 @@
 #define BUFF_SIZE 1025
 #endif
 
+#ifndef READ_SIZE
+#define READ_SIZE 65536
+#endif
+
 #include <sys/resource.h>
 
 enum RMANAGE {
@@ -16,4 +20,6 @@ void manage_rusage (enum RMANAGE, struct rusage);
 
 void show_all_resources ();
 
+int last_status ();
+
 #endif
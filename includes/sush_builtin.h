@@ -0,0 +1,46 @@
+#ifndef SUSH_BUILTIN_H
+#define SUSH_BUILTIN_H
+
+/*
+ * What a builtin loaded with  enable -f lib.so name  is written
+ * against. The module exports
+ *
+ *     const struct sush_builtin name_builtin = {
+ *         SUSH_BUILTIN_ABI, "name", "name [args]", name_run, flags
+ *     };
+ *
+ * for each builtin in it. Fields are only ever added to the end of
+ * these structs, and abi says which version of them a module knows
+ * about, so a module keeps working with newer shells.
+ */
+
+#define SUSH_BUILTIN_ABI 1
+
+/* flags */
+#define SUSH_BUILTIN_SHELL 1 // may run in the shell's own process
+
+/* one command of the line */
+struct sush_command {
+    int argc;
+    char **argv;        // NULL terminated
+};
+
+/* the line the builtin is running in, a read only view of the
+ * shell's tokenized line */
+struct sush_line {
+    int abi;
+    int cmd_ct;
+    const struct sush_command *cmds;
+    int stage;          // which of cmds is this builtin
+    int background;     // the line ended with &
+};
+
+struct sush_builtin {
+    int abi;            // SUSH_BUILTIN_ABI when the module was built
+    const char *name;
+    const char *usage;
+    int (*run) (const struct sush_line *); // returns an exit status
+    int flags;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "tokenizer.h"
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/* what one pipeline stage cost, filled in as it is reaped */
+struct stage_time {
+    pid_t pid;          // -1 if the stage never started
+    long long end_ns;   // CLOCK_MONOTONIC when it was reaped
+    struct rusage ruse;
+};
+
+int time_line (struct tok_list *);
+
+long long monotonic_ns ();
+
+void shell_usage_since (struct rusage *, struct rusage *);
+
+#endif
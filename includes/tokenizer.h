@@ -2,24 +2,100 @@
 #define TOKENIZER_H
 
 #include <stdbool.h>
+#include "arena.h"
 
-typedef struct tok_node {
-    char *token;
-    bool special;
-    struct tok_node *next;
-} tok_node;
+enum TOK_STATUS {
+    TOK_MORE,   // chunk used up, line isn't finished
+    TOK_DONE,   // a full line is in the list
+    TOK_ERROR   // line was bad and has been thrown away
+};
+
+enum TOK_KIND {
+    TOK_WORD,
+    TOK_PIPE,   // |
+    TOK_OUT,    // >
+    TOK_APPEND, // >>
+    TOK_IN,     // <
+    TOK_HEREDOC, // <<, the word after it ends up holding the body
+    TOK_HERESTR, // <<<
+    TOK_BG      // & at the end of the line
+};
+
+typedef struct token {
+    char *str;
+    enum TOK_KIND kind;
+} token;
+
+struct redirect {
+    enum TOK_KIND kind;
+    char *file;     // the text itself for << and <<<
+};
+
+/* one pipeline stage. argv is a NULL terminated slice of the list's
+ * argv array, redirs a slice of its redirect array */
+struct command {
+    char **argv;
+    int argc;
+    struct redirect *redirs;
+    int redir_ct;
+    int first_arg;
+    int first_redir;
+};
+
+struct stage_time;
 
 struct tok_list {
-    tok_node *head;
-    tok_node *tail;
+    token *toks;            // every token of the line in order
     int count;
+    int tok_cap;
+    char **argv;            // words of every command, NULL after each
+    int argv_ct;
+    int argv_cap;
+    struct redirect *redirs;
+    int redir_ct;
+    int redir_cap;
+    struct command *cmds;
+    int cmd_ct;
+    int cmd_cap;
     int pcount;
+    bool background;    // line ended in &
+    struct stage_time *times; // filled in per stage if the line is timed
+    struct arena arena; // strings for the current line
+    int state;          // tokenizer state, carried between chunks
+    char prev;          // last byte the tokenizer saw
+    char *buf;          // token being built, may span chunks
+    int buf_len;
+    int buf_cap;
+    int doc_tok;        // delimiter token of the here-doc being read
+    int doc_line;       // where its current line starts in buf
+    int var_at;         // where the $ of the variable being read is in buf
+    bool var_brace;     // it was written ${NAME}
+    bool quoted;        // the word being built had quotes in it
+    bool expanded;      // a variable or pattern was expanded on the line
+    bool glob;          // the word being built has unquoted wildcards
+    int *lits;          // where it has quoted wildcards and backslashes
+    int lit_ct;
+    int lit_cap;
 };
 
+void init_tok_list (struct tok_list*);
+
 void free_tok_list (struct tok_list*);
 
+void destroy_tok_list (struct tok_list*);
+
+enum TOK_STATUS tokenize_chunk (struct tok_list*, const char*, int, int*);
+
+enum TOK_STATUS tokenize_end (struct tok_list*);
+
+bool tokenize_pending (struct tok_list*);
+
 void tokenize (struct tok_list*, char*);
 
-void print_tokens (tok_node*);
+void add_token (struct tok_list*, char*, enum TOK_KIND);
+
+bool finish_tokens (struct tok_list*);
+
+void print_tokens (struct tok_list*);
 
 #endif
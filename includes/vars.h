@@ -0,0 +1,25 @@
+#ifndef VARS_H
+#define VARS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+const char *var_get (const char *);
+
+bool var_set (const char *, const char *, bool);
+
+bool var_export (const char *);
+
+void var_unset (const char *);
+
+bool var_assign (const char *);
+
+bool var_name_ok (const char *, size_t);
+
+unsigned long var_generation ();
+
+char **var_environ ();
+
+void var_print (bool);
+
+#endif
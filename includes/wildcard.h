@@ -0,0 +1,12 @@
+#ifndef WILDCARD_H
+#define WILDCARD_H
+
+#include <stdbool.h>
+
+#define WILDCARD_MAX_WORKERS 64
+
+bool wildcard_pattern (const char *);
+
+int wildcard_expand (const char *, void (*)(const char *, void *), void *);
+
+#endif
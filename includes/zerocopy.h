@@ -0,0 +1,10 @@
+#ifndef ZEROCOPY_H
+#define ZEROCOPY_H
+
+int cat_cmd (int, char **);
+
+int copy_cmd (int, char **);
+
+int tee_cmd (int, char **);
+
+#endif
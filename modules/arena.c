@@ -0,0 +1,165 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                  arena.c                     *
+ ************************************************
+ * Bump allocator for memory that all dies at   *
+ * the same time, like the tokens of one line.  *
+ * Resetting keeps the chunks for the next line *
+ * so steady state input needs no malloc calls  *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN(n) (((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static __thread struct arena_stats stats; // per thread, arenas aren't shared
+
+static arena_chunk *new_chunk (size_t);
+static size_t bytes_used (struct arena *);
+
+/**
+ * sets up an empty arena. retain is how many bytes of chunks a reset
+ * is allowed to keep, anything past that goes back to malloc
+ */
+void arena_init (struct arena *ar, size_t retain)
+{
+    ar->head = NULL;
+    ar->curr = NULL;
+    ar->retain = retain;
+}
+
+/**
+ * hands out size bytes, aligned for any pointer, that stay valid
+ * until the next reset
+ */
+void *arena_alloc (struct arena *ar, size_t size)
+{
+    size = ALIGN(size);
+    stats.allocs++;
+
+    /* move to the next kept chunk, or make one, if this one is full */
+    while (ar->curr == NULL || ar->curr->used + size > ar->curr->size) {
+        arena_chunk *next = ar->curr ? ar->curr->next : ar->head;
+        if (next == NULL) {
+            next = new_chunk(size);
+            if (ar->curr == NULL) {
+                ar->head = next;
+            } else {
+                ar->curr->next = next;
+            }
+        } else {
+            next->used = 0;
+        }
+        ar->curr = next;
+    }
+
+    void *mem = ar->curr->data + ar->curr->used;
+    ar->curr->used += size;
+    return mem;
+}
+
+/**
+ * copies str into the arena
+ */
+char *arena_strdup (struct arena *ar, const char *str)
+{
+    size_t length = strlen(str);
+    char *copy = arena_alloc(ar, length+1);
+    memcpy(copy, str, length+1);
+    return copy;
+}
+
+/**
+ * makes all memory handed out so far available again. chunks are kept
+ * for reuse until they add up to the arena's retain limit, the rest
+ * are freed so one huge line doesn't pin its memory forever
+ */
+void arena_reset (struct arena *ar)
+{
+    size_t used = bytes_used(ar);
+    if (used > stats.high_water) {
+        stats.high_water = used;
+    }
+    stats.resets++;
+
+    size_t kept = 0;
+    arena_chunk **link = &ar->head;
+    while (*link != NULL) {
+        arena_chunk *chunk = *link;
+        if (kept + chunk->size > ar->retain && kept > 0) {
+            *link = chunk->next;
+            free(chunk);
+            stats.frees++;
+            continue;
+        }
+        kept += chunk->size;
+        chunk->used = 0;
+        link = &chunk->next;
+    }
+    ar->curr = ar->head;
+}
+
+/**
+ * gives every chunk back to malloc
+ */
+void arena_free (struct arena *ar)
+{
+    arena_chunk *chunk = ar->head;
+    while (chunk != NULL) {
+        arena_chunk *next = chunk->next;
+        free(chunk);
+        stats.frees++;
+        chunk = next;
+    }
+    ar->head = NULL;
+    ar->curr = NULL;
+}
+
+/**
+ * copies out the allocation counters for every arena used by the
+ * calling thread
+ */
+void arena_get_stats (struct arena_stats *out)
+{
+    *out = stats;
+}
+
+/**
+ * mallocs a chunk big enough for at least size bytes
+ */
+static arena_chunk *new_chunk (size_t size)
+{
+    size_t csize = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+    arena_chunk *chunk = malloc(sizeof(arena_chunk) + csize);
+    if (chunk == NULL) {
+        perror("malloc failed in new_chunk()");
+        exit(-1);
+    }
+    stats.mallocs++;
+    chunk->next = NULL;
+    chunk->size = csize;
+    chunk->used = 0;
+    return chunk;
+}
+
+/**
+ * bytes handed out since the last reset
+ */
+static size_t bytes_used (struct arena *ar)
+{
+    size_t used = 0;
+    for (arena_chunk *chunk = ar->head; chunk != NULL; chunk = chunk->next) {
+        used += chunk->used;
+        if (chunk == ar->curr) {
+            break;
+        }
+    }
+    return used;
+}
@@ -0,0 +1,840 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 builtins.c                   *
+ ************************************************
+ * The builtin registry, and the builtins that  *
+ * can be any stage of a pipeline. Most run in  *
+ * the shell itself so echo and test glue never *
+ * starts a process. More can be loaded from    *
+ * shared objects with enable -f                *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/builtins.h"
+#include "../includes/sush_builtin.h"
+#include "../includes/hashtab.h"
+#include "../includes/internal.h"
+#include "../includes/sush.h"
+#include "../includes/parallel.h"
+#include "../includes/zerocopy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* where test is in its arguments */
+struct test_args {
+    char **argv;
+    int argc;
+    int pos;
+    bool err;
+};
+
+static struct hash_table registry;
+
+static void register_builtins ();
+static bool load_builtin (const char *, const char *);
+static bool delete_builtin (const char *);
+static void collect_builtins (hash_node *, void *);
+static int by_name (const void *, const void *);
+static int echo_cmd (int, char **);
+static int true_cmd (int, char **);
+static int false_cmd (int, char **);
+static int pwd_cmd (int, char **);
+static int test_cmd (int, char **);
+static int printf_cmd (int, char **);
+static bool test_or (struct test_args *);
+static bool test_and (struct test_args *);
+static bool test_not (struct test_args *);
+static bool test_primary (struct test_args *);
+static bool test_unary (const char *, const char *, bool *);
+static bool test_binary (const char *, const char *, const char *, bool *);
+static bool is_unary (const char *);
+static bool is_binary (const char *);
+static long long test_int (const char *, bool *);
+static bool printf_format (const char *, char ***, int *, bool *);
+static const char *print_escape (const char *, bool, bool *);
+static void print_escaped (const char *, bool, bool *);
+static long long printf_int (const char *, bool *);
+static double printf_double (const char *, bool *);
+
+/* the stage builtins, the line builtins are added by internal.c */
+static const struct builtin stage_builtins[] = {
+    { "echo", echo_cmd, NULL, BI_SHELL },
+    { "true", true_cmd, NULL, BI_SHELL },
+    { "false", false_cmd, NULL, BI_SHELL },
+    { "pwd", pwd_cmd, NULL, BI_SHELL },
+    { "test", test_cmd, NULL, BI_SHELL },
+    { "[", test_cmd, NULL, BI_SHELL },
+    { "printf", printf_cmd, NULL, BI_SHELL },
+    { "cat", cat_cmd, NULL, BI_SHELL },
+    { "copy", copy_cmd, NULL, BI_SHELL },
+    { "tee", tee_cmd, NULL, BI_SHELL },
+    { "parallel", parallel_cmd, NULL, 0 }, // waits for its own children
+};
+
+/**
+ * the builtin called name, or NULL if it isn't one
+ */
+struct builtin *find_builtin (const char *name)
+{
+    if (registry.buckets == NULL) {
+        register_builtins();
+    }
+    return ht_get(&registry, name);
+}
+
+/**
+ * adds a builtin to the registry, with either run for a stage
+ * builtin or line for a line builtin
+ */
+void add_builtin (const char *name, int (*run) (int, char **),
+        bool (*line) (int, char **), int flags)
+{
+    struct builtin *b = calloc(1, sizeof(struct builtin));
+    if (b == NULL) {
+        perror("calloc failed in add_builtin()");
+        exit(-1);
+    }
+    b->run = run;
+    b->line = line;
+    b->flags = flags;
+    b->name = ht_put(&registry, name, b)->key;
+}
+
+/**
+ * runs the builtin that is stage of the line, wherever it has been
+ * set up to run. returns its exit status
+ */
+int run_builtin (struct builtin *b, struct tok_list *tlist, int stage)
+{
+    if (b->loaded == NULL) {
+        return b->run(tlist->cmds[stage].argc, tlist->cmds[stage].argv);
+    }
+
+    /* what a loaded builtin can see of the line */
+    struct sush_command cmds[tlist->cmd_ct];
+    for (int i = 0; i < tlist->cmd_ct; i++) {
+        cmds[i].argc = tlist->cmds[i].argc;
+        cmds[i].argv = tlist->cmds[i].argv;
+    }
+    struct sush_line line = {
+        SUSH_BUILTIN_ABI, tlist->cmd_ct, cmds, stage, tlist->background
+    };
+    return b->loaded->run(&line);
+}
+
+/**
+ * enable                      list the builtins and how often each ran
+ * enable -f lib.so name ...   load builtins from a shared object
+ * enable -d name ...          unload builtins loaded with -f
+ */
+bool enable_cmd (int argc, char **argv)
+{
+    if (argc == 1) {
+        struct builtin *list[registry.count + 1];
+        struct builtin **fill = list;
+        ht_foreach(&registry, collect_builtins, &fill);
+        int ct = fill - list;
+        qsort(list, ct, sizeof(struct builtin *), by_name);
+        for (int i = 0; i < ct; i++) {
+            printf("%-12s %8lu  %s\n", list[i]->name, list[i]->uses,
+                    list[i]->path ? list[i]->path
+                    : list[i]->line ? "line" : "stage");
+        }
+        return false; // no error
+    }
+
+    bool load = !strcmp(argv[1], "-f");
+    if ((!load && strcmp(argv[1], "-d")) || argc < (load ? 4 : 3)) {
+        fprintf(stderr, "usage: enable [-f lib.so name ... | -d name ...]\n");
+        return true; // error
+    }
+    bool err = false;
+    for (int i = load ? 3 : 2; i < argc; i++) {
+        if (load) {
+            err = load_builtin(argv[2], argv[i]) || err;
+        } else {
+            err = delete_builtin(argv[i]) || err;
+        }
+    }
+    return err;
+}
+
+/**
+ * fills the registry with the shell's own builtins
+ */
+static void register_builtins ()
+{
+    ht_init(&registry, 64);
+    for (size_t i = 0; i < sizeof(stage_builtins) / sizeof(stage_builtins[0]);
+            i++) {
+        const struct builtin *b = &stage_builtins[i];
+        add_builtin(b->name, b->run, NULL, b->flags);
+    }
+    register_internal_cmds();
+}
+
+/**
+ * adds the builtin called name from the shared object at path, which
+ * has to export name_builtin. returns true on error
+ */
+static bool load_builtin (const char *path, const char *name)
+{
+    if (find_builtin(name) != NULL) {
+        fprintf(stderr, "enable: %s is already a builtin\n", name);
+        return true; // error
+    }
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "enable: %s\n", dlerror());
+        return true; // error
+    }
+    char sym[strlen(name) + sizeof("_builtin")];
+    sprintf(sym, "%s_builtin", name);
+    const struct sush_builtin *def = dlsym(handle, sym);
+    if (def == NULL || def->abi < 1 || def->abi > SUSH_BUILTIN_ABI
+            || def->run == NULL) {
+        fprintf(stderr, "enable: %s has no usable %s\n", path, sym);
+        dlclose(handle);
+        return true; // error
+    }
+
+    add_builtin(name, NULL, NULL,
+            (def->flags & SUSH_BUILTIN_SHELL) ? BI_SHELL : 0);
+    struct builtin *b = find_builtin(name);
+    b->loaded = def;
+    b->handle = handle;
+    b->path = strdup(path);
+    return false; // no error
+}
+
+/**
+ * takes a builtin loaded with enable -f back out. returns true on
+ * error
+ */
+static bool delete_builtin (const char *name)
+{
+    struct builtin *b = find_builtin(name);
+    if (b == NULL || b->loaded == NULL) {
+        fprintf(stderr, "enable: %s wasn't loaded with -f\n", name);
+        return true; // error
+    }
+    ht_remove(&registry, name);
+    dlclose(b->handle);
+    free(b->path);
+    free(b);
+    return false; // no error
+}
+
+/**
+ * ht_foreach() callback that gathers the builtins into an array
+ */
+static void collect_builtins (hash_node *node, void *arg)
+{
+    struct builtin ***fill = arg;
+    *(*fill)++ = node->value;
+}
+
+/**
+ * qsort() order for builtins, by name
+ */
+static int by_name (const void *a, const void *b)
+{
+    const struct builtin *x = *(struct builtin * const *)a;
+    const struct builtin *y = *(struct builtin * const *)b;
+    return strcmp(x->name, y->name);
+}
+
+/**
+ * echo [-neE] [arg ...]
+ * prints its args. -n leaves off the newline, -e turns on backslash
+ * escapes and -E turns them back off, like /bin/echo
+ */
+static int echo_cmd (int argc, char **argv)
+{
+    bool newline = true;
+    bool escapes = false;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strspn(argv[i] + 1, "neE") != strlen(argv[i] + 1)) {
+            break; // not options, so it gets printed
+        }
+        for (char *c = argv[i] + 1; *c; c++) {
+            if (*c == 'n') {
+                newline = false;
+            } else {
+                escapes = *c == 'e';
+            }
+        }
+    }
+
+    bool stop = false;
+    for (int first = i; i < argc && !stop; i++) {
+        if (i > first) {
+            putchar(' ');
+        }
+        if (escapes) {
+            print_escaped(argv[i], true, &stop);
+        } else {
+            fputs(argv[i], stdout);
+        }
+    }
+    if (newline && !stop) {
+        putchar('\n');
+    }
+    return 0;
+}
+
+/**
+ * true     does nothing, successfully
+ */
+static int true_cmd (int argc, char **argv)
+{
+    return 0;
+}
+
+/**
+ * false    does nothing, unsuccessfully
+ */
+static int false_cmd (int argc, char **argv)
+{
+    return 1;
+}
+
+/**
+ * print the current working directory to STDOUT
+ */
+static int pwd_cmd (int argc, char **argv)
+{
+    char buff[BUFF_SIZE];
+    if (getcwd(buff, BUFF_SIZE) == NULL) {
+        perror("couldn't get current working directory");
+        return 1;
+    }
+    printf("%s\n", buff);
+    return 0;
+}
+
+/**
+ * test expr  or  [ expr ]
+ * returns 0 if expr is true, 1 if it's false and 2 if it can't be
+ * understood. expr is made of
+ *   string, -n string, -z string, s1 = s2, s1 != s2, s1 < s2, s1 > s2
+ *   n1 -eq|-ne|-lt|-le|-gt|-ge n2
+ *   -e|-f|-d|-r|-w|-x|-s|-L|-h|-p|-S|-b|-c|-u|-g|-k|-O|-G file, -t fd
+ *   f1 -nt|-ot|-ef f2
+ *   ! expr, expr -a expr, expr -o expr, ( expr )
+ */
+static int test_cmd (int argc, char **argv)
+{
+    if (!strcmp(argv[0], "[")) {
+        if (strcmp(argv[argc-1], "]")) {
+            fprintf(stderr, "[: missing ]\n");
+            return 2;
+        }
+        argc--;
+    }
+    if (argc == 1) {
+        return 1; // nothing is false
+    }
+
+    struct test_args t = { argv + 1, argc - 1, 0, false };
+    bool result = test_or(&t);
+    if (!t.err && t.pos < t.argc) {
+        fprintf(stderr, "%s: extra argument %s\n", argv[0], t.argv[t.pos]);
+        t.err = true;
+    }
+    if (t.err) {
+        return 2;
+    }
+    return result ? 0 : 1;
+}
+
+/**
+ * expr -o expr ...
+ */
+static bool test_or (struct test_args *t)
+{
+    bool result = test_and(t);
+    while (!t->err && t->pos < t->argc && !strcmp(t->argv[t->pos], "-o")) {
+        t->pos++;
+        result = test_and(t) || result;
+    }
+    return result;
+}
+
+/**
+ * expr -a expr ..., which binds tighter than -o
+ */
+static bool test_and (struct test_args *t)
+{
+    bool result = test_not(t);
+    while (!t->err && t->pos < t->argc && !strcmp(t->argv[t->pos], "-a")) {
+        t->pos++;
+        result = test_not(t) && result;
+    }
+    return result;
+}
+
+/**
+ * ! expr
+ */
+static bool test_not (struct test_args *t)
+{
+    /* a lone ! is a string, and "! = x" compares it */
+    if (t->pos + 1 < t->argc && !strcmp(t->argv[t->pos], "!")
+            && !(t->pos + 2 < t->argc && is_binary(t->argv[t->pos+1]))) {
+        t->pos++;
+        return !test_not(t);
+    }
+    return test_primary(t);
+}
+
+/**
+ * a single test. a binary operator in the middle wins over anything
+ * else, so "-n = -n" compares two strings like POSIX says it should
+ */
+static bool test_primary (struct test_args *t)
+{
+    if (t->pos >= t->argc) {
+        fprintf(stderr, "test: argument expected\n");
+        t->err = true;
+        return false;
+    }
+    char **a = t->argv + t->pos;
+    int left = t->argc - t->pos;
+
+    if (left >= 3 && is_binary(a[1])) {
+        t->pos += 3;
+        return test_binary(a[0], a[1], a[2], &t->err);
+    }
+    if (!strcmp(a[0], "(") && left >= 2) {
+        t->pos++;
+        bool result = test_or(t);
+        if (!t->err && (t->pos >= t->argc || strcmp(t->argv[t->pos], ")"))) {
+            fprintf(stderr, "test: missing )\n");
+            t->err = true;
+        }
+        t->pos++;
+        return result;
+    }
+    if (left >= 2 && is_unary(a[0])) {
+        t->pos += 2;
+        return test_unary(a[0], a[1], &t->err);
+    }
+    t->pos++;
+    return a[0][0] != '\0'; // a string on its own is true if not empty
+}
+
+/**
+ * true for the operators that take one argument
+ */
+static bool is_unary (const char *op)
+{
+    return op[0] == '-' && op[1] != '\0' && op[2] == '\0'
+        && strchr("bcdefghknprstuwxzLOGS", op[1]) != NULL;
+}
+
+/**
+ * true for the operators that go between two arguments
+ */
+static bool is_binary (const char *op)
+{
+    static const char *ops[] = { "=", "==", "!=", "<", ">", "-eq", "-ne",
+        "-lt", "-le", "-gt", "-ge", "-nt", "-ot", "-ef", NULL };
+    for (int i = 0; ops[i] != NULL; i++) {
+        if (!strcmp(op, ops[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * op arg, where op is one of the unary operators
+ */
+static bool test_unary (const char *op, const char *arg, bool *err)
+{
+    switch (op[1]) {
+    case 'n':
+        return arg[0] != '\0';
+    case 'z':
+        return arg[0] == '\0';
+    case 't':
+        return isatty(test_int(arg, err));
+    case 'r':
+        return access(arg, R_OK) == 0;
+    case 'w':
+        return access(arg, W_OK) == 0;
+    case 'x':
+        return access(arg, X_OK) == 0;
+    }
+
+    struct stat st;
+    if (op[1] == 'h' || op[1] == 'L') {
+        return lstat(arg, &st) == 0 && S_ISLNK(st.st_mode);
+    }
+    if (stat(arg, &st) < 0) {
+        return false;
+    }
+    switch (op[1]) {
+    case 'e':
+        return true;
+    case 'f':
+        return S_ISREG(st.st_mode);
+    case 'd':
+        return S_ISDIR(st.st_mode);
+    case 'b':
+        return S_ISBLK(st.st_mode);
+    case 'c':
+        return S_ISCHR(st.st_mode);
+    case 'p':
+        return S_ISFIFO(st.st_mode);
+    case 'S':
+        return S_ISSOCK(st.st_mode);
+    case 's':
+        return st.st_size > 0;
+    case 'u':
+        return (st.st_mode & S_ISUID) != 0;
+    case 'g':
+        return (st.st_mode & S_ISGID) != 0;
+    case 'k':
+        return (st.st_mode & S_ISVTX) != 0;
+    case 'O':
+        return st.st_uid == geteuid();
+    case 'G':
+        return st.st_gid == getegid();
+    }
+    return false;
+}
+
+/**
+ * a op b, where op is one of the binary operators
+ */
+static bool test_binary (const char *a, const char *op, const char *b,
+        bool *err)
+{
+    if (!strcmp(op, "=") || !strcmp(op, "==")) {
+        return !strcmp(a, b);
+    } else if (!strcmp(op, "!=")) {
+        return strcmp(a, b) != 0;
+    } else if (!strcmp(op, "<")) {
+        return strcmp(a, b) < 0;
+    } else if (!strcmp(op, ">")) {
+        return strcmp(a, b) > 0;
+    }
+
+    if (!strcmp(op, "-nt") || !strcmp(op, "-ot") || !strcmp(op, "-ef")) {
+        struct stat sa;
+        struct stat sb;
+        bool has_a = stat(a, &sa) == 0;
+        bool has_b = stat(b, &sb) == 0;
+        if (op[1] == 'e') {
+            return has_a && has_b && sa.st_dev == sb.st_dev
+                && sa.st_ino == sb.st_ino;
+        }
+        if (!has_a || !has_b) {
+            /* a file that exists is newer than one that doesn't */
+            return op[1] == 'n' ? has_a : has_b;
+        }
+        long long ta = sa.st_mtim.tv_sec * 1000000000LL + sa.st_mtim.tv_nsec;
+        long long tb = sb.st_mtim.tv_sec * 1000000000LL + sb.st_mtim.tv_nsec;
+        return op[1] == 'n' ? ta > tb : ta < tb;
+    }
+
+    long long x = test_int(a, err);
+    long long y = test_int(b, err);
+    if (!strcmp(op, "-eq")) {
+        return x == y;
+    } else if (!strcmp(op, "-ne")) {
+        return x != y;
+    } else if (!strcmp(op, "-lt")) {
+        return x < y;
+    } else if (!strcmp(op, "-le")) {
+        return x <= y;
+    } else if (!strcmp(op, "-gt")) {
+        return x > y;
+    }
+    return x >= y;
+}
+
+/**
+ * an integer argument of test, which may have blanks around it
+ */
+static long long test_int (const char *s, bool *err)
+{
+    char *end;
+    errno = 0;
+    long long n = strtoll(s, &end, 10);
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (end == s || *end != '\0' || errno != 0) {
+        fprintf(stderr, "test: %s: integer expression expected\n", s);
+        *err = true;
+    }
+    return n;
+}
+
+/**
+ * printf format [arg ...]
+ * prints the args the way format says, like the C printf. the format
+ * is used again as long as there are args left over. %b prints an arg
+ * with its backslash escapes turned into characters
+ */
+static int printf_cmd (int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: printf format [arg ...]\n");
+        return 2;
+    }
+    char **args = argv + 2;
+    int left = argc - 2;
+    bool err = false;
+    while (true) {
+        int before = left;
+        if (!printf_format(argv[1], &args, &left, &err)) {
+            break; // \c
+        }
+        if (left == 0 || left == before) {
+            break; // every arg used, or the format doesn't use any
+        }
+    }
+    return err ? 1 : 0;
+}
+
+/**
+ * prints the format once, taking args from *args as conversions need
+ * them. returns false if a \c said to stop printing altogether
+ */
+static bool printf_format (const char *fmt, char ***args, int *left,
+        bool *err)
+{
+    bool stop = false;
+    const char *c = fmt;
+    while (*c && !stop) {
+        if (*c == '\\') {
+            c = print_escape(c + 1, false, &stop);
+            continue;
+        }
+        if (*c != '%') {
+            putchar(*c++);
+            continue;
+        }
+        if (c[1] == '%') {
+            putchar('%');
+            c += 2;
+            continue;
+        }
+
+        /* the flags, width and precision are passed on as they are,
+         * with * filled in from the args */
+        const char *spec_start = c;
+        char spec[64];
+        int len = 0;
+        spec[len++] = *c++;
+        int stars[2];
+        int star_ct = 0;
+        while (*c && strchr("-+ #0", *c) && len < 32) {
+            spec[len++] = *c++;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*c != '.') {
+                    break;
+                }
+                spec[len++] = *c++;
+            }
+            if (*c == '*') {
+                spec[len++] = *c++;
+                stars[star_ct] = 0;
+                if (*left > 0) {
+                    stars[star_ct] = printf_int(**args, err);
+                    (*args)++;
+                    (*left)--;
+                }
+                star_ct++;
+            } else {
+                while (isdigit((unsigned char)*c) && len < 48) {
+                    spec[len++] = *c++;
+                }
+            }
+        }
+
+        char conv = *c;
+        if (conv == '\0' || strchr("diouxXcsbfFeEgGaA", conv) == NULL) {
+            fprintf(stderr, "printf: bad conversion %.*s\n",
+                    (int)(c - spec_start) + (conv != '\0'), spec_start);
+            *err = true;
+            return true;
+        }
+        c++;
+        char *arg = "";
+        if (*left > 0) {
+            arg = **args;
+            (*args)++;
+            (*left)--;
+        }
+
+        if (conv == 'b') {
+            print_escaped(arg, true, &stop);
+            continue;
+        }
+        if (strchr("diouxX", conv)) {
+            spec[len++] = 'l'; // the arg is always a long long
+            spec[len++] = 'l';
+        }
+        spec[len++] = conv;
+        spec[len] = '\0';
+
+        if (conv == 's' || conv == 'c') {
+            char ch[2] = { arg[0], '\0' };
+            const char *val = conv == 's' ? arg : ch;
+            if (conv == 'c') {
+                spec[len-1] = 's'; // so an empty arg prints nothing
+            }
+            if (star_ct == 2) {
+                printf(spec, stars[0], stars[1], val);
+            } else if (star_ct == 1) {
+                printf(spec, stars[0], val);
+            } else {
+                printf(spec, val);
+            }
+        } else if (strchr("diouxX", conv)) {
+            long long val = printf_int(arg, err);
+            if (star_ct == 2) {
+                printf(spec, stars[0], stars[1], val);
+            } else if (star_ct == 1) {
+                printf(spec, stars[0], val);
+            } else {
+                printf(spec, val);
+            }
+        } else {
+            double val = printf_double(arg, err);
+            if (star_ct == 2) {
+                printf(spec, stars[0], stars[1], val);
+            } else if (star_ct == 1) {
+                printf(spec, stars[0], val);
+            } else {
+                printf(spec, val);
+            }
+        }
+    }
+    return !stop;
+}
+
+/**
+ * prints the character for the escape starting just after a
+ * backslash and returns where the escape ends. octal is \0NNN when
+ * zero_octal, the way echo and %b write it, and \NNN otherwise like
+ * a printf format. \c sets *stop
+ */
+static const char *print_escape (const char *s, bool zero_octal, bool *stop)
+{
+    static const char *from = "\\abefnrtv";
+    static const char *to = "\\\a\b\033\f\n\r\t\v";
+    const char *esc = *s ? strchr(from, *s) : NULL;
+    if (esc != NULL) {
+        putchar(to[esc - from]);
+        return s + 1;
+    }
+    if (*s == 'c') {
+        *stop = true;
+        return s + 1;
+    }
+
+    int value = 0;
+    int digits = 0;
+    const char *c = s;
+    if (*c == 'x' && isxdigit((unsigned char)c[1])) {
+        for (c++; digits < 2 && isxdigit((unsigned char)*c); c++, digits++) {
+            value = value * 16 + (isdigit((unsigned char)*c) ? *c - '0'
+                    : tolower((unsigned char)*c) - 'a' + 10);
+        }
+        putchar(value);
+        return c;
+    }
+    if (zero_octal ? *c == '0' : (*c >= '0' && *c <= '7')) {
+        if (zero_octal) {
+            c++;
+        }
+        for (; digits < 3 && *c >= '0' && *c <= '7'; c++, digits++) {
+            value = value * 8 + *c - '0';
+        }
+        putchar(value);
+        return c;
+    }
+
+    putchar('\\'); // not an escape, so the backslash stays
+    return s;
+}
+
+/**
+ * prints s with its backslash escapes turned into characters. stops
+ * at \c and sets *stop
+ */
+static void print_escaped (const char *s, bool zero_octal, bool *stop)
+{
+    while (*s && !*stop) {
+        if (*s == '\\') {
+            s = print_escape(s + 1, zero_octal, stop);
+        } else {
+            putchar(*s++);
+        }
+    }
+}
+
+/**
+ * an integer arg of printf. 'c or "c gives the character's value
+ */
+static long long printf_int (const char *s, bool *err)
+{
+    if (s[0] == '\'' || s[0] == '"') {
+        return (unsigned char)s[1];
+    }
+    if (s[0] == '\0') {
+        return 0;
+    }
+    char *end;
+    errno = 0;
+    long long n = strtoll(s, &end, 0);
+    if (errno == ERANGE && s[0] != '-') {
+        n = (long long)strtoull(s, &end, 0); // too big for signed
+        errno = 0;
+    }
+    if (*end != '\0' || errno != 0) {
+        fprintf(stderr, "printf: %s: invalid number\n", s);
+        *err = true;
+    }
+    return n;
+}
+
+/**
+ * a floating point arg of printf
+ */
+static double printf_double (const char *s, bool *err)
+{
+    if (s[0] == '\'' || s[0] == '"') {
+        return (unsigned char)s[1];
+    }
+    if (s[0] == '\0') {
+        return 0;
+    }
+    char *end;
+    errno = 0;
+    double d = strtod(s, &end);
+    if (*end != '\0' || errno != 0) {
+        fprintf(stderr, "printf: %s: invalid number\n", s);
+        *err = true;
+    }
+    return d;
+}
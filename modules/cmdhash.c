@@ -0,0 +1,280 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 cmdhash.c                    *
+ ************************************************
+ * Remembers where each command was found in    *
+ * $PATH so it only has to be searched for      *
+ * once. Misses are remembered too. The table   *
+ * is thrown away when $PATH changes or when a  *
+ * $PATH directory is modified, which is looked *
+ * at no more than once per command line        *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/cmdhash.h"
+#include "../includes/hashtab.h"
+#include "../includes/vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+struct cmd_entry {
+    char *path; // NULL if the command wasn't found
+    int dir;    // index of the $PATH dir it was found in, -1 if none
+    int hits;
+};
+
+struct path_dir {
+    char *dir;
+    struct timespec mtime;
+};
+
+static struct hash_table cmd_table;
+static struct path_dir *dirs = NULL;
+static int dir_ct = 0;
+static char *saved_path = NULL;
+static unsigned long saved_gen; // var_generation() when it was saved
+static unsigned long line_gen = 1;  // bumped for every command line
+static unsigned long checked_gen = 0; // line_gen when dirs were checked
+
+static void sync_path ();
+static void stamp_dirs ();
+static bool dirs_changed ();
+static struct cmd_entry *resolve (const char *);
+static void free_entry (void *);
+static void print_entry (hash_node *, void *);
+
+/**
+ * returns the full path of the given command, or NULL if it is
+ * not in any $PATH directory. results are cached until $PATH
+ * changes, or until one of the directories is seen to have been
+ * modified. the directories are only stat'd by the first lookup
+ * of each command line, so a hit costs one hash table probe
+ */
+const char *cmd_lookup (const char *name)
+{
+    sync_path();
+    if (checked_gen != line_gen) {
+        checked_gen = line_gen;
+        if (dirs_changed()) {
+            cmd_hash_forget();
+        }
+    }
+
+    struct cmd_entry *entry = ht_get(&cmd_table, name);
+    if (entry != NULL) {
+        entry->hits++;
+        return entry->path;
+    }
+
+    entry = resolve(name);
+    ht_put(&cmd_table, name, entry);
+    return entry->path;
+}
+
+/**
+ * remembers path as the location of name without searching for it
+ */
+void cmd_hash_set (const char *name, const char *path)
+{
+    sync_path();
+
+    struct cmd_entry *entry = malloc(sizeof(struct cmd_entry));
+    if (entry == NULL) {
+        perror("malloc failed in cmd_hash_set()");
+        return;
+    }
+    entry->path = strdup(path);
+    entry->dir = -1; // not tied to any $PATH dir
+    entry->hits = 0;
+    free_entry(ht_remove(&cmd_table, name));
+    ht_put(&cmd_table, name, entry);
+}
+
+/**
+ * drops every remembered location
+ */
+void cmd_hash_forget ()
+{
+    ht_clear(&cmd_table, free_entry);
+    stamp_dirs();
+    checked_gen = line_gen; // the stamps are as new as they get
+}
+
+/**
+ * call before each command line. the next lookup checks whether
+ * any $PATH directory was modified since the last line
+ */
+void cmd_hash_new_line ()
+{
+    line_gen++;
+}
+
+/**
+ * prints the remembered commands. reusable prints them as hash -p
+ * commands that can be put in a .sushrc
+ */
+void cmd_hash_print (bool reusable)
+{
+    if (!reusable) {
+        printf("hits\tcommand\n");
+    }
+    ht_foreach(&cmd_table, print_entry, &reusable);
+}
+
+/**
+ * rebuilds the directory list if $PATH isn't what it was the
+ * last time a command was looked up. $PATH is only looked at again
+ * once some variable has changed
+ */
+static void sync_path ()
+{
+    if (saved_path != NULL && saved_gen == var_generation()) {
+        return;
+    }
+    saved_gen = var_generation();
+    const char *fpath = var_get("PATH");
+    if (fpath == NULL) {
+        fpath = "";
+    }
+    if (saved_path != NULL && !strcmp(saved_path, fpath)) {
+        return;
+    }
+
+    for (int i = 0; i < dir_ct; i++) {
+        free(dirs[i].dir);
+    }
+    free(dirs);
+    free(saved_path);
+    dirs = NULL;
+    dir_ct = 0;
+    saved_path = strdup(fpath);
+
+    /* one dir per colon separated piece, empty pieces are skipped */
+    int max = 1;
+    for (const char *c = fpath; *c; c++) {
+        if (*c == ':') {
+            max++;
+        }
+    }
+    dirs = calloc(max, sizeof(struct path_dir));
+    if (dirs == NULL) {
+        perror("calloc failed in sync_path()");
+        exit(-1);
+    }
+    const char *start = fpath;
+    while (*start) {
+        const char *end = strchr(start, ':');
+        int length = end ? end - start : (int)strlen(start);
+        if (length > 0) {
+            dirs[dir_ct++].dir = strndup(start, length);
+        }
+        start += length;
+        if (*start == ':') {
+            start++;
+        }
+    }
+
+    cmd_hash_forget();
+}
+
+/**
+ * records the modification time of every $PATH dir
+ */
+static void stamp_dirs ()
+{
+    struct stat st;
+    for (int i = 0; i < dir_ct; i++) {
+        if (stat(dirs[i].dir, &st) == 0) {
+            dirs[i].mtime = st.st_mtim;
+        } else {
+            dirs[i].mtime.tv_sec = 0;
+            dirs[i].mtime.tv_nsec = 0;
+        }
+    }
+}
+
+/**
+ * checks whether any of the $PATH dirs have been modified since
+ * they were stamped
+ */
+static bool dirs_changed ()
+{
+    struct stat st;
+    for (int i = 0; i < dir_ct; i++) {
+        if (stat(dirs[i].dir, &st) < 0) {
+            st.st_mtim.tv_sec = 0;
+            st.st_mtim.tv_nsec = 0;
+        }
+        if (st.st_mtim.tv_sec != dirs[i].mtime.tv_sec
+                || st.st_mtim.tv_nsec != dirs[i].mtime.tv_nsec) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * searches the $PATH dirs in order for an executable file called name
+ */
+static struct cmd_entry *resolve (const char *name)
+{
+    struct cmd_entry *entry = malloc(sizeof(struct cmd_entry));
+    if (entry == NULL) {
+        perror("malloc failed in resolve()");
+        exit(-1);
+    }
+    entry->path = NULL;
+    entry->dir = -1;
+    entry->hits = 1;
+
+    char full[PATH_MAX];
+    struct stat st;
+    for (int i = 0; i < dir_ct; i++) {
+        int length = snprintf(full, PATH_MAX, "%s/%s", dirs[i].dir, name);
+        if (length >= PATH_MAX) {
+            continue;
+        }
+        if (stat(full, &st) == 0 && S_ISREG(st.st_mode)
+                && access(full, X_OK) == 0) {
+            entry->path = strdup(full);
+            entry->dir = i;
+            break;
+        }
+    }
+    return entry;
+}
+
+/**
+ * frees a cmd_entry, for use with ht_clear()
+ */
+static void free_entry (void *value)
+{
+    struct cmd_entry *entry = value;
+    if (entry != NULL) {
+        free(entry->path);
+        free(entry);
+    }
+}
+
+/**
+ * prints a single remembered command, skipping misses
+ */
+static void print_entry (hash_node *node, void *arg)
+{
+    struct cmd_entry *entry = node->value;
+    if (entry->path == NULL) {
+        return;
+    }
+    if (*(bool *)arg) {
+        printf("hash -p %s %s\n", entry->path, node->key);
+    } else {
+        printf("%4d\t%s\n", entry->hits, entry->path);
+    }
+}
@@ -7,255 +7,644 @@
  ************************************************
  * Author: Justin Weigle                        *
  *         Richard Bucco                        *
- * Edited: 19 Apr 2020                          *
+ * Edited: 16 Oct 2026                          *
  ************************************************/
 
+#define _GNU_SOURCE
 #include "../includes/executor.h"
 #include "../includes/sush.h"
+#include "../includes/cmdhash.h"
+#include "../includes/options.h"
+#include "../includes/jobs.h"
+#include "../includes/timing.h"
+#include "../includes/builtins.h"
+#include "../includes/vars.h"
+#include "../includes/ledger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdbool.h>
-#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
-#include <sys/wait.h>
+#include <limits.h>
+#include <spawn.h>
+#include <signal.h>
+#include <sys/mman.h>
 
-typedef struct path_node {
-    char *path;
-    struct path_node *next;
-} path_node;
-
-struct p_list {
-    path_node *head;
-    path_node *tail;
-    int count;
-};
-
-struct subsection {
-    tok_node *head;
-    tok_node *tail;
-    int count;
-};
+static volatile sig_atomic_t interrupted; // ^C during an in-shell builtin
 
 enum Read_Write {
     READ,
     WRITE
 };
 
-static void parse_cmd (struct subsection, struct p_list);
-static struct subsection get_next_subsection (tok_node *);
-static bool bin_exists (char *, struct p_list);
+/* what execute() decided about one stage before starting it */
+struct stage_plan {
+    struct builtin *builtin;    // a stage builtin, or NULL
+    char *bin;                  // the command's path, from find_bin()
+};
+
+static void parse_cmd (struct command *, const char *);
+static void apply_redirects (struct command *);
+static int run_in_shell (struct builtin *, struct tok_list *, int, int, int,
+        int);
+static bool shell_redirects (struct command *);
+static void run_stage (struct command *, struct stage_plan *,
+        struct tok_list *, int, int, int [2], pid_t, bool);
+static int spawn_cmd (struct command *, const char *, int, int, pid_t,
+        bool, pid_t *);
+static void spawn_attr_init (posix_spawnattr_t *, bool, pid_t);
+static const char *exec_file (const char *, const char *);
+static void child_signals ();
+static void note_interrupt (int);
+static int redirect_flags (enum Read_Write, bool);
+static char *find_bin (char *);
 static int get_fd (char *, enum Read_Write, bool);
 static void output_to_file (char *, bool);
 static void file_to_input (char *);
-static struct p_list get_path();
-static void save_path(char *, struct p_list *);
-static void free_path (struct p_list *);
+static int doc_fd (struct redirect *);
+static bool write_all (int, const char *, size_t);
 
 /**
- * Counts how many pipes there are in the given linked list of tokens and
- * forks() a process for each command and pipes between them as necessary
+ * Runs each command of the tokenized line as its own process and
+ * pipes between them as necessary. The processes are handed to the
+ * jobs module as one job. One builtin stage of a foreground line runs
+ * in the shell instead, once everything around it has started, unless
+ * it is part of a pipeline under job control.
+ * Returns the exit status of the last command, 128+n if it was killed
+ * by signal n, or 0 if the line was started in the background
  */
-void execute (struct tok_list *tlist)
+int execute (struct tok_list *tlist)
 {
-    int pipe_ct = tlist->pcount;
-    /* number of pipes+1 is number of processes to fork() */
-    int cmd_ct = pipe_ct + 1;
-
-    /* allocate storage for the cmd(s) */
-    struct subsection cmds[cmd_ct];
-
-    /* split input into separate cmds if pipe(s) */
-    tok_node *curr = tlist->head;
-    for (int i = 0; i < cmd_ct; i++) {
-        cmds[i] = get_next_subsection(curr);
-        curr = cmds[i].tail;
-        if(curr->next != NULL) { // move to next non pipe token
-            curr = curr->next->next;
+    for (int i = 0; i < tlist->cmd_ct; i++) {
+        if (tlist->cmds[i].argc == 0) {
+            fprintf(stderr, "Empty command\n");
+            return 1;
         }
     }
+    if (tlist->cmd_ct == 0) {
+        return 0;
+    }
+    if (!strcmp(tlist->cmds[0].argv[0], "time")) {
+        return time_line(tlist); // runs the rest of the line
+    }
 
-    /* create variables for pipes */
-    int pipefd[pipe_ct][2];
+    int cmd_ct = tlist->cmd_ct;
 
-    /* create the pipes */
-    for (int i = 0; i < pipe_ct; i++) {
-        if (pipe(pipefd[i]) < 0) {
-            perror("new pipe, who dis");
-        }
+    /* the tokenizer already split the input into separate cmds */
+    struct command *cmds = tlist->cmds;
+
+    /* the plan lives on the heap, a generated line can have thousands
+     * of stages */
+    struct stage_plan *plan = calloc(cmd_ct, sizeof(struct stage_plan));
+    pid_t *pids = calloc(cmd_ct, sizeof(pid_t));
+    if (plan == NULL || pids == NULL) {
+        perror("calloc failed in execute()");
+        exit(-1);
     }
 
-    /* for forks */
-    int status;
+    long long start = monotonic_ns();
     pid_t pid;
+    pid_t pgid = 0; // first stage's pid once it starts, with job control
+    bool bg_stdin = tlist->background && !job_control();
 
-    /* rusage struct for each child process */
-    struct rusage child_ruses[cmd_ct];
-
-    /* path for checking for binaries */
-    struct p_list plist = get_path();
+    /* look up binaries here so the results stay cached in the shell,
+     * builtins don't need one */
+    int in_shell = -1; // the stage the shell runs itself, if any
+    for (int i = 0; i < cmd_ct; i++) {
+        struct builtin *b = find_builtin(cmds[i].argv[0]);
+        if (b != NULL && b->run == NULL && b->loaded == NULL) {
+            b = NULL; // a line builtin, not as a stage
+        }
+        plan[i].builtin = b;
+        plan[i].bin = b ? NULL : find_bin(cmds[i].argv[0]);
+        if (b != NULL) {
+            b->uses++; // here, since most run in a child
+        }
+        /* with job control the other stages don't get the terminal
+         * until the shell waits on them, and one reading it would stop
+         * while the shell is still blocked writing to it, so the
+         * builtin only runs here when it is the whole line */
+        if (in_shell < 0 && b != NULL && !tlist->background
+                && (b->flags & BI_SHELL)
+                && (cmd_ct == 1 || !job_control())) {
+            in_shell = i;
+        }
+    }
 
-    /* fork for every cmd in input */
+    /* forked stages exec with this, so it is put together once here
+     * if a variable changed rather than in every child */
+    var_environ();
+
+    /* each pipe is made just before the stage writing to it starts, as
+     * big as setopt pipesize asks, and the shell closes its ends once
+     * the stages on both sides have them. so the shell never holds
+     * more than one pipe and a bit, and with O_CLOEXEC an exec'd stage
+     * sees only its own two ends however long the line is. the stage
+     * the shell runs itself keeps its ends until it has run */
+    long pipe_size = get_option(OPT_PIPESIZE);
+    int in_fd = -1;     // read end of the pipe into stage i
+    int shell_in = -1;
+    int shell_out = -1;
+
+    /* start every cmd in input, all stages run at the same time */
     for (int i = 0; i < cmd_ct; i++) {
+        int next[2] = { -1, -1 };
+        if (i+1 < cmd_ct) { // if there is a next command
+            if (pipe2(next, O_CLOEXEC) < 0) {
+                perror("new pipe, who dis");
+            } else if (pipe_size > 0) {
+                /* a pipe that can't grow, because the user has too
+                 * many big ones, still works */
+                fcntl(next[0], F_SETPIPE_SZ, (int)pipe_size);
+            }
+        }
+
         fflush(NULL); // flush all open output streams(especially pipes)
-        pid = fork();
-        if (pid < 0) {
-            perror("ahhhh, fork() this");
-            exit(-1);
-        } else if (pid == 0) { // child
-            signal(SIGINT, SIG_DFL);
-            if (i > 0) { // if not the first cmd
-                /* connect read end of prev proc pipe to STDIN of curr proc */
-                if (dup2(pipefd[i-1][0], STDIN_FILENO) < 0) {
-                    perror("f's in the chat boys, dup2 failed");
+        pids[i] = -1;
+        struct builtin *b = plan[i].builtin;
+        if (i == in_shell) {
+            pids[i] = 0; // runs after the loop
+            shell_in = in_fd;
+            shell_out = next[1];
+            in_fd = next[0];
+            continue;
+        }
+        bool started = false;
+        if (get_option(OPT_SPAWN) == SPAWN_POSIX && b == NULL) {
+            /* posix_spawn if the cmd can be described to it */
+            int ret = spawn_cmd(&cmds[i], plan[i].bin, in_fd, next[1],
+                    pgid, i == 0 && bg_stdin, &pid);
+            if (ret == 0) {
+                pids[i] = pid;
+                if (job_control() && pgid == 0) {
+                    pgid = pid;
                 }
-                close(pipefd[i-1][0]); // close read end prev proc pipe
-                close(pipefd[i-1][1]); // close write end prev proc pipe
             }
-            if (i+1 < cmd_ct) { // if there is a next command
-                close(pipefd[i][0]); // close read end of curr proc pipe
-                /* connect write end of curr proc pipe to STDOUT */
-                if (dup2(pipefd[i][1], STDOUT_FILENO) < 0) {
-                    perror("f's in the chat boys, dup2 failed");
+            started = ret <= 0;
+        }
+        if (!started) {
+            pid = fork();
+            if (pid < 0) {
+                perror("ahhhh, fork() this");
+                exit(-1);
+            } else if (pid == 0) { // child
+                child_signals();
+                if (shell_in >= 0) {
+                    close(shell_in);
                 }
-                close(pipefd[i][1]); // close write end curr proc pipe
+                if (shell_out >= 0) {
+                    close(shell_out);
+                }
+                run_stage(&cmds[i], &plan[i], tlist, i, in_fd, next,
+                        pgid, i == 0 && bg_stdin);
             }
-            parse_cmd(cmds[i], plist); // parse and exec curr command
-            perror("exec failed"); // if parse_cmd returns, error
-            exit(-1);
-        } else { // parent
-            if (i > 0) { // make sure prev proc pipes are closed
-                close(pipefd[i-1][0]); // close read end prev proc pipe
-                close(pipefd[i-1][1]); // close write end prev proc pipe
+            pids[i] = pid;
+            if (job_control()) {
+                /* also done here so the group exists before anything
+                 * gives it the terminal */
+                setpgid(pid, pgid ? pgid : pid);
+                pgid = pgid ? pgid : pid;
             }
-            /* wait for children to terminate */
-            while(wait3(&status, 0, &child_ruses[i]) <= 0) {}
         }
+
+        /* this stage has its ends now */
+        if (in_fd >= 0) {
+            close(in_fd);
+        }
+        if (next[1] >= 0) {
+            close(next[1]);
+        }
+        in_fd = next[0];
     }
 
-    /* store the rusage info from each child into the "global"
-     * SUSH rusage struct */
     for (int i = 0; i < cmd_ct; i++) {
-        manage_rusage(UPDATE, child_ruses[i]);
+        free(plan[i].bin);
     }
 
-    /* free memory allocated for path */
-    free_path(&plist);
+    /* every stage it reads from or writes to is running now */
+    int line = ledger_new_line();
+    int shell_status = 0;
+    if (in_shell >= 0) {
+        shell_status = run_in_shell(plan[in_shell].builtin, tlist, in_shell,
+                shell_in, shell_out, line);
+    }
+    free(plan);
 
-    return;
+    /* the jobs module waits for the children, in whatever order they
+     * finish, and adds up their rusage */
+    int status = jobs_launch(tlist, pids, cmd_ct, pgid, start, line);
+    free(pids);
+    return in_shell == cmd_ct-1 ? shell_status : status;
 }
 
 /**
- * Takes a single command and parses it to find any redirects, then
- * executes the command
+ * the rest of a forked child's work for stage i: joins the job's
+ * process group, puts stdin and stdout on the pipes around it, then
+ * runs the builtin or execs the command. never returns
  */
-static void parse_cmd (struct subsection cmd_ll, struct p_list plist)
+static void run_stage (struct command *cmd_d, struct stage_plan *plan,
+        struct tok_list *tlist, int stage, int in_fd, int next[2],
+        pid_t pgid, bool bg_stdin)
 {
-    /* allocate strings for each token plus room for a NULL */
-    char *cmd[cmd_ll.count +1];
-
-    tok_node *curr = cmd_ll.head;
-    int i = 0;
-    /* build command. stop at first redirect or end */
-    while ((curr != NULL) && !(curr->special)) {
-        cmd[i++] = curr->token;
-        curr = curr->next;
-    }
-    cmd[i] = NULL; // end of cmd must be NULL for exec
-
-    curr = cmd_ll.head;
-    /* stop when curr is whatever is right after the tail of the command */
-    while (curr != NULL && curr != cmd_ll.tail->next) {
-        if (curr->special) {
-            if (!strcmp(curr->token, ">")) {
-                /* next token should be output file, append false */
-                output_to_file(curr->next->token, false);
-            }
-            if (!strcmp(curr->token, ">>")) {
-                /* next token should be output file, append true */
-                output_to_file(curr->next->token, true);
-            }
-            if (!strcmp(curr->token, "<")) {
-                /* next token should be input to current cmd */
-                file_to_input(curr->next->token);
-            }
+    if (job_control()) {
+        setpgid(0, pgid); // the first stage starts the group
+    }
+    if (bg_stdin) {
+        /* without job control nothing stops a background job
+         * from reading the shell's input, so it gets none */
+        file_to_input("/dev/null");
+    }
+    if (in_fd >= 0) { // if not the first cmd
+        /* connect read end of prev proc pipe to STDIN of curr proc */
+        if (dup2(in_fd, STDIN_FILENO) < 0) {
+            perror("f's in the chat boys, dup2 failed");
         }
-        curr = curr->next;
+        close(in_fd);
+    }
+    if (next[1] >= 0) { // if there is a next command
+        /* connect write end of curr proc pipe to STDOUT */
+        if (dup2(next[1], STDOUT_FILENO) < 0) {
+            perror("f's in the chat boys, dup2 failed");
+        }
+        close(next[0]); // the next stage's, not this one's
+        close(next[1]);
+    }
+    if (plan->builtin != NULL) {
+        /* a builtin stage the shell isn't running itself runs
+         * in this child instead of being exec'd */
+        apply_redirects(cmd_d);
+        exit(run_builtin(plan->builtin, tlist, stage));
+    }
+    parse_cmd(cmd_d, plan->bin); // redirect and exec curr command
+    perror("exec failed"); // if parse_cmd returns, error
+    exit(-1);
+}
+
+/**
+ * runs builtin stage of the line in the shell with its stdin and
+ * stdout on in_fd and out_fd, -1 to leave them, and its own
+ * redirects, then puts the shell's back and closes in_fd and out_fd.
+ * what it cost, from when it started and the shell's own rusage, goes
+ * in the ledger as part of line, and in the line's times if it is
+ * being timed. returns its exit status
+ */
+static int run_in_shell (struct builtin *b, struct tok_list *tlist,
+        int stage, int in_fd, int out_fd, int line)
+{
+    struct command *cmd = &tlist->cmds[stage];
+    long long start = monotonic_ns();
+    struct rusage before;
+    getrusage(RUSAGE_SELF, &before);
+
+    int saved_in = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);
+    int saved_out = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+    if (in_fd >= 0) {
+        dup2(in_fd, STDIN_FILENO);
+        close(in_fd);
+    }
+    if (out_fd >= 0) {
+        dup2(out_fd, STDOUT_FILENO);
+        close(out_fd);
+    }
+
+    /* a reader that quits early gets the builtin a write error, not
+     * the whole shell a SIGPIPE. ^C interrupts whatever it is blocked
+     * in so it can stop, rather than being ignored like the shell does */
+    void (*old_pipe) (int) = signal(SIGPIPE, SIG_IGN);
+    struct sigaction on_int = { .sa_handler = note_interrupt };
+    struct sigaction old_int;
+    sigemptyset(&on_int.sa_mask);
+    interrupted = 0;
+    sigaction(SIGINT, &on_int, &old_int);
+    int status = 1;
+    if (!shell_redirects(cmd)) {
+        status = run_builtin(b, tlist, stage);
+    }
+    fflush(stdout);
+    clearerr(stdout);
+    sigaction(SIGINT, &old_int, NULL);
+    signal(SIGPIPE, old_pipe);
+    if (interrupted) {
+        status = 128 + SIGINT;
     }
 
+    if (saved_in >= 0) {
+        dup2(saved_in, STDIN_FILENO);
+        close(saved_in);
+    }
+    if (saved_out >= 0) {
+        dup2(saved_out, STDOUT_FILENO);
+        close(saved_out);
+    }
+
+    long long end = monotonic_ns();
+    struct rusage used;
+    shell_usage_since(&before, &used);
+    ledger_add(line, stage+1, cmd->argv[0], getpid(), start, end, status,
+            &used);
+    if (tlist->times != NULL) {
+        struct stage_time *time = &tlist->times[stage];
+        time->pid = getpid();
+        time->end_ns = end;
+        time->ruse = used;
+    }
+    return status;
+}
+
+/**
+ * true once ^C has been pressed while a builtin runs in the shell,
+ * which should then stop. never true in a forked stage, where ^C just
+ * kills it
+ */
+bool builtin_interrupted ()
+{
+    return interrupted;
+}
+
+/**
+ * SIGINT handler while a builtin runs in the shell
+ */
+static void note_interrupt (int sig)
+{
+    interrupted = 1;
+}
+
+/**
+ * puts back the signal handling the shell changed for itself, for
+ * a forked child about to exec
+ */
+static void child_signals ()
+{
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    sigprocmask(SIG_SETMASK, jobs_child_mask(), NULL);
+}
+
+/**
+ * Takes a single command, sets up its redirects, then executes
+ * the command. bin is the command's full path if it was found in
+ * the path
+ */
+static void parse_cmd (struct command *cmd_d, const char *bin)
+{
+    char **cmd = cmd_d->argv;
+
+    apply_redirects(cmd_d);
+
     /* run commands locally if they start with ./ or / */
     if (cmd[0][0] == '/') {
         cmd[0] = cmd[0] + 1;
-        execv(cmd[0], cmd);
+        execve(cmd[0], cmd, var_environ());
     } else if (cmd[0][0] == '.') {
         if (cmd[0][1] == '/') {
-            execv(cmd[0], cmd);
+            execve(cmd[0], cmd, var_environ());
         }
     /* if the cmd is a bin in the path, execute */
-    } else if (bin_exists(cmd[0], plist)) {
-        execvp(cmd[0], cmd);
+    } else if (bin != NULL) {
+        execve(bin, cmd, var_environ());
     } else {
         fprintf(stderr, "command %s does not exist", cmd[0]);
-        exit(0);
+        exit(127);
     }
     perror("could not exec in parse_cmd");
     exit(-1);
 }
 
 /**
- * Gets the next cmd subsection of the linked list based on whether
- * it reaches the end or it finds a |
+ * points stdin and stdout at a command's redirect files
  */
-static struct subsection get_next_subsection (tok_node *curr)
+static void apply_redirects (struct command *cmd_d)
 {
-    struct subsection cmd;
-    cmd.head = curr; // head assumed to be first node passed in
-
-    int count = 0;
-    tok_node *prev = NULL;
-    while (curr != NULL) {
-        if (curr->special) {
-            if (!strcmp(curr->token, "|")) { // if pipe found
-                cmd.tail = prev; // then prev token is the tail
-                break;
+    for (int i = 0; i < cmd_d->redir_ct; i++) {
+        struct redirect *r = &cmd_d->redirs[i];
+        if (r->kind == TOK_OUT) {
+            output_to_file(r->file, false); // append false
+        } else if (r->kind == TOK_APPEND) {
+            output_to_file(r->file, true); // append true
+        } else if (r->kind == TOK_IN) {
+            file_to_input(r->file); // file is input to current cmd
+        } else {
+            int fd = doc_fd(r); // << or <<<
+            if (fd < 0) {
+                perror("here-document");
+                exit(-1);
             }
+            dup2(fd, STDIN_FILENO);
+            close(fd);
         }
-        prev = curr;
-        curr = curr->next;
-        if (curr == NULL) { // if end was found
-            cmd.tail = prev; // the prev token is the tail
+    }
+}
+
+/**
+ * apply_redirects() for a builtin running in the shell, where a file
+ * that can't be opened fails the command instead of exiting. returns
+ * true on error
+ */
+static bool shell_redirects (struct command *cmd_d)
+{
+    for (int i = 0; i < cmd_d->redir_ct; i++) {
+        struct redirect *r = &cmd_d->redirs[i];
+        enum Read_Write rw = r->kind == TOK_OUT || r->kind == TOK_APPEND
+            ? WRITE : READ;
+        int fd;
+        if (r->kind == TOK_HEREDOC || r->kind == TOK_HERESTR) {
+            fd = doc_fd(r);
+        } else {
+            fd = open(r->file, redirect_flags(rw, r->kind == TOK_APPEND),
+                    S_IWUSR | S_IRUSR);
         }
-        count++;
+        if (fd < 0) {
+            fprintf(stderr, "%s: %s\n", r->kind == TOK_IN || rw == WRITE
+                    ? r->file : "here-document", strerror(errno));
+            return true; // error
+        }
+        dup2(fd, rw == READ ? STDIN_FILENO : STDOUT_FILENO);
+        close(fd);
+    }
+    return false; // no error
+}
+
+/**
+ * Starts argv as a command of its own with its stdin, stdout and
+ * stderr on the given fds, for builtins like parallel that run
+ * commands. It stays in the caller's process group. Returns its pid,
+ * or -1 if it couldn't be started
+ */
+pid_t spawn_argv (char **argv, int in_fd, int out_fd, int err_fd)
+{
+    char *bin = find_bin(argv[0]);
+    const char *file = exec_file(argv[0], bin);
+    if (file == NULL) {
+        fprintf(stderr, "command %s does not exist\n", argv[0]);
+        free(bin);
+        return -1;
     }
-    cmd.count = count;
 
-    return cmd;
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    spawn_attr_init(&attr, false, 0);
+    posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_fd, STDERR_FILENO);
+
+    char *arg0 = argv[0];
+    if (arg0[0] == '/') {
+        argv[0] = arg0 + 1; // parse_cmd() strips the / from argv[0] too
+    }
+    pid_t pid;
+    int err = posix_spawn(&pid, file, &actions, &attr, argv, var_environ());
+    argv[0] = arg0;
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) {
+        fprintf(stderr, "could not spawn %s: %s\n", file, strerror(err));
+        pid = -1;
+    }
+    free(bin);
+    return pid;
 }
 
 /**
- * checks the path environment variable to see if bin is in it
+ * Does what fork() followed by run_stage() would do using posix_spawn,
+ * which never copies the shell's page tables. The pipe and redirect
+ * steps become file actions, in_fd and out_fd being the pipe ends for
+ * stdin and stdout or -1. Returns 0 and sets pid if the cmd was
+ * started, -1 if it couldn't be, and 1 if the cmd needs something a
+ * file action can't express so the caller should fork instead
  */
-static bool bin_exists (char *bin, struct p_list plist)
+static int spawn_cmd (struct command *cmd_d, const char *bin, int in_fd,
+        int out_fd, pid_t pgid, bool bg_stdin, pid_t *pid)
 {
-    bool found = false;
-    DIR *dir;
-    struct dirent *entry;
-    path_node *list = plist.head;
-
-    /* search path to see if the given string bin is in the directories */
-    while (list != NULL && found == false) {
-        if ((dir = opendir(list->path)) != NULL) {
-            while ((entry = readdir(dir)) != NULL && found == false) {
-                if (!strcmp(entry->d_name, bin)) { // if true, the bin exists
-                    found = true;
-                }
-            }
+    char **cmd = cmd_d->argv;
+    char *arg0 = cmd[0];
+    const char *file = exec_file(arg0, bin);
+    if (file == NULL) {
+        return 1; // error reporting is left to parse_cmd()
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    spawn_attr_init(&attr, job_control(), pgid);
+
+    /* pipes, exactly as the forked child would set them up. every
+     * other fd the shell has open is close on exec */
+    if (in_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN_FILENO);
+    }
+    if (out_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    }
+
+    if (bg_stdin) {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO,
+                "/dev/null", O_RDONLY, 0);
+    }
+
+    /* redirects, in the order they were typed. here-doc text is put
+     * in an fd now for the child to take as its stdin */
+    int doc_fds[cmd_d->redir_ct];
+    int doc_ct = 0;
+    bool docs_ok = true;
+    for (int i = 0; docs_ok && i < cmd_d->redir_ct; i++) {
+        struct redirect *r = &cmd_d->redirs[i];
+        if (r->kind == TOK_OUT || r->kind == TOK_APPEND) {
+            posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO,
+                    r->file, redirect_flags(WRITE, r->kind == TOK_APPEND),
+                    S_IWUSR | S_IRUSR);
+        } else if (r->kind == TOK_IN) {
+            posix_spawn_file_actions_addopen(&actions, STDIN_FILENO,
+                    r->file, redirect_flags(READ, false), 0);
+        } else if ((doc_fds[doc_ct] = doc_fd(r)) >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, doc_fds[doc_ct++],
+                    STDIN_FILENO);
+        } else {
+            perror("here-document");
+            docs_ok = false;
         }
-        list = list->next;
     }
-    closedir(dir);
-    return found;
+
+    if (arg0[0] == '/') {
+        cmd[0] = arg0 + 1; // parse_cmd() strips the / from argv[0] too
+    }
+    int err = -1;
+    if (docs_ok) {
+        err = posix_spawn(pid, file, &actions, &attr, cmd, var_environ());
+    }
+    cmd[0] = arg0;
+    for (int i = 0; i < doc_ct; i++) {
+        close(doc_fds[i]);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (err < 0) {
+        return -1; // already reported
+    }
+    if (err != 0) {
+        fprintf(stderr, "could not spawn %s: %s\n", file, strerror(err));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * sets up spawn attributes so the child doesn't ignore ^C and ^Z
+ * like the shell does, or keep SIGCHLD blocked. with set_pgroup it
+ * joins process group pgid, where 0 starts a new group
+ */
+static void spawn_attr_init (posix_spawnattr_t *attr, bool set_pgroup,
+        pid_t pgid)
+{
+    posix_spawnattr_init(attr);
+    sigset_t sigdef;
+    sigemptyset(&sigdef);
+    sigaddset(&sigdef, SIGINT);
+    sigaddset(&sigdef, SIGTSTP);
+    sigaddset(&sigdef, SIGTTIN);
+    sigaddset(&sigdef, SIGTTOU);
+    posix_spawnattr_setsigdefault(attr, &sigdef);
+    posix_spawnattr_setsigmask(attr, jobs_child_mask());
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    if (set_pgroup) {
+        posix_spawnattr_setpgroup(attr, pgid);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(attr, flags);
+}
+
+/**
+ * same rules as parse_cmd() for which file gets exec'd, NULL if
+ * there isn't one
+ */
+static const char *exec_file (const char *arg0, const char *bin)
+{
+    if (arg0[0] == '/') {
+        return arg0 + 1;
+    } else if (arg0[0] == '.' && arg0[1] == '/') {
+        return arg0;
+    } else if (arg0[0] != '.' && bin != NULL) {
+        return bin;
+    }
+    return NULL;
+}
+
+/**
+ * finds the full path of a cmd that isn't run locally using the
+ * shell's command hash table. returns a copy the caller frees, since
+ * a later lookup can flush the table
+ */
+static char *find_bin (char *cmd)
+{
+    if (cmd[0] == '/' || cmd[0] == '.' || strchr(cmd, '/') != NULL) {
+        return NULL;
+    }
+    const char *bin = cmd_lookup(cmd);
+    return bin ? strdup(bin) : NULL;
 }
 
 /**
@@ -266,16 +655,10 @@ static int get_fd (char *f, enum Read_Write rw, bool append)
     int fd;
     if (rw == READ) {
         /* open f READ only */
-        fd = open(f, O_RDONLY, S_IRUSR | S_IRGRP | S_IROTH);
-    }
-    if (rw == WRITE) {
-        if (append) {
-            /* open f WRITE only with append turned on */
-            fd = open(f, O_WRONLY | O_CREAT | O_APPEND, S_IWUSR | S_IRUSR);
-        } else {
-            /* open f WRITE only without append turned on */
-            fd = open(f, O_WRONLY | O_CREAT, S_IWUSR | S_IRUSR);
-        }
+        fd = open(f, redirect_flags(rw, append), S_IRUSR | S_IRGRP | S_IROTH);
+    } else {
+        /* open f WRITE only, append decides if O_APPEND is on */
+        fd = open(f, redirect_flags(rw, append), S_IWUSR | S_IRUSR);
     }
     if (fd < 0) {
         perror("open failed in get_fd\n");
@@ -285,6 +668,20 @@ static int get_fd (char *f, enum Read_Write rw, bool append)
     return fd;
 }
 
+/**
+ * open() flags used for a redirect, shared by fork and posix_spawn
+ */
+static int redirect_flags (enum Read_Write rw, bool append)
+{
+    if (rw == READ) {
+        return O_RDONLY;
+    }
+    if (append) {
+        return O_WRONLY | O_CREAT | O_APPEND;
+    }
+    return O_WRONLY | O_CREAT;
+}
+
 /**
  * redirect stdout to the file listed after >
  * append controls whether the file is appended or overwritten
@@ -309,77 +706,60 @@ static void file_to_input (char *fname)
 }
 
 /**
- * gets the user's path environment variable and returns it
- * as a linked list
+ * an fd to read the text of a << or <<< redirect from, a here-string
+ * getting a newline after it. small texts go straight into a pipe,
+ * bigger ones into a sealed memfd, so nothing is written to disk and
+ * there's nothing to clean up. returns -1 with errno set on error
  */
-static struct p_list get_path()
+static int doc_fd (struct redirect *r)
 {
-    char *fpath = getenv("PATH"); // get path
-    int length = strlen(fpath);
-    char path[length]; // make buffer to store individual path strings
-    struct p_list plist;
-    plist.head = NULL;
-    plist.tail = NULL;
-    plist.count = 0;
-
-    /* go through full path(fpath) searching for colons, which are the
-     * delimiters of the path environment variable */
-    for (int i = 0, j = 0; i < length; i++) {
-        if (fpath[i] == ':') {
-            path[j] = '\0';
-            save_path(path, &plist);
-            j = 0;
-        } else {
-            path[j++] = fpath[i];
+    size_t len = strlen(r->file);
+    bool newline = r->kind == TOK_HERESTR;
+    int fd;
+    if (len + newline <= PIPE_BUF) { // always fits in a new pipe
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) < 0) {
+            return -1;
+        }
+        write_all(fds[1], r->file, len);
+        if (newline) {
+            write_all(fds[1], "\n", 1);
         }
+        close(fds[1]);
+        return fds[0];
     }
 
-    return plist;
-}
-
-/**
- * saves a path into a path_node linked list
- */
-static void save_path(char *path, struct p_list *plist)
-{
-    path_node *p_node = malloc(sizeof(path_node)); // make new node
-    if (p_node == NULL) {
-        perror("malloc failed in save_path()");
-    }
-    int length = strlen(path);
-    p_node->path = malloc(sizeof(char)*length+1); // make space for path
-    if (p_node->path == NULL) {
-        perror("malloc failed in save_path()");
-    }
-    strncpy(p_node->path, path, length+1); // put path in node
-    p_node->path[length] = '\0'; // in case strncpy doesn't null terminate
-    p_node->next = NULL; // set next to NULL, node is going at the end
-
-    if (plist->head == NULL) { // if phead is NULL, new node is phead
-        plist->head = p_node;
-        plist->tail = p_node;
-        return;
-    } else { // otherwise insert node at the end
-        plist->tail->next = p_node;
-        plist->tail = p_node;
-    }
-    plist->count++; // another node
-    return;
+    fd = memfd_create("sush-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -1;
+    }
+    if (!write_all(fd, r->file, len) || (newline && !write_all(fd, "\n", 1))
+            || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW
+                | F_SEAL_WRITE | F_SEAL_SEAL) < 0
+            || lseek(fd, 0, SEEK_SET) < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
 }
 
 /**
- * takes a path linked list and frees it
+ * writes all len bytes of buf to fd. returns false if it couldn't
  */
-static void free_path (struct p_list *plist)
+static bool write_all (int fd, const char *buf, size_t len)
 {
-    path_node *temp = plist->head;
-    while (temp != NULL) {
-        plist->head = plist->head->next;
-        free(temp->path);
-        free(temp);
-        temp = plist->head;
-    }
-    plist->head = NULL;
-    plist->tail = NULL;
-    plist->count = 0;
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
 }
@@ -0,0 +1,201 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 hashtab.c                    *
+ ************************************************
+ * Small chained hash table keyed by strings.   *
+ * Used wherever SUSH needs to map a name to    *
+ * some piece of state without scanning a list  *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/hashtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned int hash_string (const char *);
+static void grow_table (struct hash_table *);
+
+/**
+ * sets up an empty table with the given number of buckets,
+ * size should be a power of two
+ */
+void ht_init (struct hash_table *table, int size)
+{
+    table->buckets = calloc(size, sizeof(hash_node *));
+    if (table->buckets == NULL) {
+        perror("calloc failed in ht_init()");
+        exit(-1);
+    }
+    table->size = size;
+    table->count = 0;
+}
+
+/**
+ * returns the node stored under key or NULL if there isn't one
+ */
+hash_node *ht_find (struct hash_table *table, const char *key)
+{
+    if (table->buckets == NULL) {
+        return NULL;
+    }
+    unsigned int hash = hash_string(key);
+    hash_node *node = table->buckets[hash & (table->size - 1)];
+    while (node != NULL) {
+        if (node->hash == hash && !strcmp(node->key, key)) {
+            return node;
+        }
+        node = node->next;
+    }
+    return NULL;
+}
+
+/**
+ * returns the value stored under key or NULL if there isn't one
+ */
+void *ht_get (struct hash_table *table, const char *key)
+{
+    hash_node *node = ht_find(table, key);
+    return node ? node->value : NULL;
+}
+
+/**
+ * stores value under key, replacing the value of an existing
+ * node if key is already in the table. returns the node
+ */
+hash_node *ht_put (struct hash_table *table, const char *key, void *value)
+{
+    hash_node *node = ht_find(table, key);
+    if (node != NULL) {
+        node->value = value;
+        return node;
+    }
+
+    if (table->buckets == NULL) {
+        ht_init(table, 64);
+    } else if (table->count >= table->size) { // keep chains short
+        grow_table(table);
+    }
+
+    node = malloc(sizeof(hash_node));
+    if (node == NULL) {
+        perror("malloc failed in ht_put()");
+        exit(-1);
+    }
+    node->key = strdup(key);
+    if (node->key == NULL) {
+        perror("strdup failed in ht_put()");
+        exit(-1);
+    }
+    node->value = value;
+    node->hash = hash_string(key);
+
+    int idx = node->hash & (table->size - 1);
+    node->next = table->buckets[idx];
+    table->buckets[idx] = node;
+    table->count++;
+    return node;
+}
+
+/**
+ * unlinks the node stored under key and returns its value so
+ * the caller can free it
+ */
+void *ht_remove (struct hash_table *table, const char *key)
+{
+    if (table->buckets == NULL) {
+        return NULL;
+    }
+    unsigned int hash = hash_string(key);
+    hash_node **link = &table->buckets[hash & (table->size - 1)];
+    while (*link != NULL) {
+        hash_node *node = *link;
+        if (node->hash == hash && !strcmp(node->key, key)) {
+            void *value = node->value;
+            *link = node->next;
+            free(node->key);
+            free(node);
+            table->count--;
+            return value;
+        }
+        link = &node->next;
+    }
+    return NULL;
+}
+
+/**
+ * removes every node, calling free_val on each value if it
+ * isn't NULL. the buckets are kept for reuse
+ */
+void ht_clear (struct hash_table *table, void (*free_val)(void *))
+{
+    for (int i = 0; table->buckets != NULL && i < table->size; i++) {
+        hash_node *node = table->buckets[i];
+        while (node != NULL) {
+            hash_node *next = node->next;
+            if (free_val != NULL) {
+                free_val(node->value);
+            }
+            free(node->key);
+            free(node);
+            node = next;
+        }
+        table->buckets[i] = NULL;
+    }
+    table->count = 0;
+}
+
+/**
+ * calls fn on every node in the table. fn must not add or
+ * remove nodes
+ */
+void ht_foreach (struct hash_table *table,
+        void (*fn)(hash_node *, void *), void *arg)
+{
+    for (int i = 0; table->buckets != NULL && i < table->size; i++) {
+        for (hash_node *node = table->buckets[i]; node; node = node->next) {
+            fn(node, arg);
+        }
+    }
+}
+
+/**
+ * FNV-1a, cheap and good enough for command and variable names
+ */
+static unsigned int hash_string (const char *str)
+{
+    unsigned int hash = 2166136261u;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * doubles the number of buckets and rehashes every node
+ */
+static void grow_table (struct hash_table *table)
+{
+    int size = table->size * 2;
+    hash_node **buckets = calloc(size, sizeof(hash_node *));
+    if (buckets == NULL) {
+        return; // table still works, just with longer chains
+    }
+    for (int i = 0; i < table->size; i++) {
+        hash_node *node = table->buckets[i];
+        while (node != NULL) {
+            hash_node *next = node->next;
+            int idx = node->hash & (size - 1);
+            node->next = buckets[idx];
+            buckets[idx] = node;
+            node = next;
+        }
+    }
+    free(table->buckets);
+    table->buckets = buckets;
+    table->size = size;
+}
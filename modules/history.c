@@ -0,0 +1,642 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 history.c                    *
+ ************************************************
+ * Keeps every line typed at the prompt in an   *
+ * append only file that any number of shells   *
+ * can add to at once, and an index of it so    *
+ * the history builtin can search millions of   *
+ * lines quickly. Nothing is read until history *
+ * is run                                       *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include "../includes/history.h"
+#include "../includes/vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HIST_MAGIC "SUSHHST\n"
+#define INDEX_MAGIC "SUSHHIX\n"
+#define HIST_VERSION 1
+#define REC_MAGIC 0x52485355u // "USHR" read as little endian
+#define BLOCK_ENTRIES 64      // lines per substring filter
+#define BLOOM_BITS 4096       // bits in each filter
+#define REINDEX_TAIL 1024     // fewest unindexed lines worth reindexing
+
+/* the log starts with this, then records one after another. each is
+ * written with a single write() to an O_APPEND fd, so lines from
+ * different shells can't interleave. a record cut short by a crash
+ * fails its checksum and the reader skips to the next magic */
+struct hist_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t pad;
+};
+
+struct hist_record {
+    uint32_t magic;
+    uint32_t len;       // followed by len bytes of line, padded to 4
+    uint32_t sum;       // FNV-1a of the line
+    uint32_t when;      // seconds since the epoch
+};
+
+/* the index, rebuilt whole and renamed into place. entry n of the
+ * log is at offsets[n], sorted[] lists entries in the order of their
+ * text for prefix searches, and each block of BLOCK_ENTRIES entries
+ * has a bloom filter of the trigrams in it for substring searches */
+struct index_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;     // entries indexed
+    uint64_t log_size;  // bytes of the log they came from
+    uint64_t log_ino;
+    uint32_t block_ct;
+    uint32_t pad;
+};
+
+/* the log and its index, mapped while history runs */
+struct history {
+    char path[PATH_MAX];
+    char idx_path[PATH_MAX + 8];
+    const char *log;
+    size_t log_len;
+    ino_t log_ino;
+    const char *idx;
+    size_t idx_len;
+    uint32_t indexed;   // entries the index covers
+    const uint64_t *offsets;
+    const uint32_t *sorted;
+    const uint8_t *blooms;
+    uint64_t *tail;     // offsets of entries after those
+    uint32_t tail_ct;
+    uint32_t tail_cap;
+};
+
+static bool history_path (char *);
+static int open_log (const char *);
+static bool load (struct history *);
+static bool load_index (struct history *);
+static void unload (struct history *);
+static uint64_t next_record (const char *, uint64_t, uint64_t);
+static const char *entry_text (struct history *, uint32_t, uint32_t *);
+static uint32_t entry_count (struct history *);
+static bool build_index (struct history *);
+static int by_text (const void *, const void *);
+static int by_number (const void *, const void *);
+static void add_trigrams (uint8_t *, const char *, uint32_t);
+static bool maybe_has (const uint8_t *, const char *, size_t);
+static unsigned trigram (const char *);
+static uint32_t fnv1a (const char *, size_t);
+static void print_entry (struct history *, uint32_t);
+static void search_prefix (struct history *, const char *);
+static void search_text (struct history *, const char *);
+
+static int log_fd = -1;     // opened by the first line added
+static char *pending = NULL; // text of the line being read
+static size_t pending_len = 0;
+static size_t pending_cap = 0;
+static struct history *sorting; // for by_text()
+
+/**
+ * adds some of the raw text of the line being read, which can come in
+ * any number of pieces
+ */
+void history_collect (const char *text, size_t len)
+{
+    if (pending_len + len > pending_cap) {
+        size_t cap = pending_cap ? pending_cap : 256;
+        while (cap < pending_len + len) {
+            cap *= 2;
+        }
+        char *bigger = realloc(pending, cap);
+        if (bigger == NULL) {
+            perror("realloc failed in history_collect()");
+            exit(-1);
+        }
+        pending = bigger;
+        pending_cap = cap;
+    }
+    memcpy(pending + pending_len, text, len);
+    pending_len += len;
+}
+
+/**
+ * the line collected so far is finished, so it is appended to the
+ * history file. blank lines aren't kept
+ */
+void history_end_line ()
+{
+    size_t len = pending_len;
+    pending_len = 0;
+    while (len > 0 && (pending[len-1] == '\n' || pending[len-1] == ' ')) {
+        len--;
+    }
+    if (len == 0 || len > UINT32_MAX - 8) {
+        return;
+    }
+    if (log_fd < 0) {
+        char path[PATH_MAX];
+        if (!history_path(path) || (log_fd = open_log(path)) < 0) {
+            return; // no history is better than no shell
+        }
+    }
+
+    size_t size = sizeof(struct hist_record) + ((len + 3) & ~(size_t)3);
+    char *rec = calloc(1, size);
+    if (rec == NULL) {
+        return;
+    }
+    struct hist_record hdr = { REC_MAGIC, len, fnv1a(pending, len),
+        (uint32_t)time(NULL) };
+    memcpy(rec, &hdr, sizeof(hdr));
+    memcpy(rec + sizeof(hdr), pending, len);
+    if (write(log_fd, rec, size) != (ssize_t)size) {
+        perror("history");
+    }
+    free(rec);
+}
+
+/**
+ * history             every line, numbered from the oldest
+ * history n           the last n lines
+ * history -p prefix   lines starting with prefix
+ * history -s text     lines with text anywhere in them
+ */
+bool history_cmd (int argc, char **argv)
+{
+    struct history h;
+    memset(&h, 0, sizeof(h));
+    if (!history_path(h.path)) {
+        fprintf(stderr, "history: no $HISTFILE or $HOME\n");
+        return true; // error
+    }
+    if (!load(&h)) {
+        return false; // nothing kept yet
+    }
+
+    bool err = false;
+    uint32_t ct = entry_count(&h);
+    if (argc == 3 && !strcmp(argv[1], "-p")) {
+        search_prefix(&h, argv[2]);
+    } else if (argc == 3 && !strcmp(argv[1], "-s")) {
+        search_text(&h, argv[2]);
+    } else if (argc <= 2 && (argc == 1 || argv[1][0] != '-')) {
+        uint32_t n = argc == 2 ? strtoul(argv[1], NULL, 10) : ct;
+        for (uint32_t i = n < ct ? ct - n : 0; i < ct; i++) {
+            print_entry(&h, i);
+        }
+    } else {
+        fprintf(stderr, "usage: history [n | -p prefix | -s text]\n");
+        err = true;
+    }
+    unload(&h);
+    return err;
+}
+
+/**
+ * $HISTFILE, or ~/.sush_history. false if there's neither
+ */
+static bool history_path (char *path)
+{
+    const char *file = var_get("HISTFILE");
+    const char *home = var_get("HOME");
+    int length;
+    if (file != NULL && file[0] != '\0') {
+        length = snprintf(path, PATH_MAX, "%s", file);
+    } else if (home != NULL) {
+        length = snprintf(path, PATH_MAX, "%s/.sush_history", home);
+    } else {
+        return false;
+    }
+    return length < PATH_MAX;
+}
+
+/**
+ * opens the log for appending, making it first if it isn't there. a
+ * new log is written whole under another name and linked into place
+ * so no shell ever sees one without its header
+ */
+static int open_log (const char *path)
+{
+    int fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd >= 0 || errno != ENOENT) {
+        return fd;
+    }
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+    int tmp_fd = mkstemp(tmp);
+    if (tmp_fd < 0) {
+        return -1;
+    }
+    struct hist_header hdr = { .version = HIST_VERSION };
+    memcpy(hdr.magic, HIST_MAGIC, 8);
+    bool ok = write(tmp_fd, &hdr, sizeof(hdr)) == sizeof(hdr);
+    close(tmp_fd);
+    if (ok) {
+        link(tmp, path); // fails if another shell beat this one to it
+    }
+    unlink(tmp);
+    return open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+}
+
+/**
+ * maps the log and its index and finds the entries the index doesn't
+ * cover yet, reindexing if there are a lot of them. returns false if
+ * there is no history
+ */
+static bool load (struct history *h)
+{
+    snprintf(h->idx_path, sizeof(h->idx_path), "%s.idx", h->path);
+    int fd = open(h->path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0
+            || (size_t)st.st_size < sizeof(struct hist_header)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    h->log_len = st.st_size;
+    h->log_ino = st.st_ino;
+    h->log = mmap(NULL, h->log_len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (h->log == MAP_FAILED) {
+        h->log = NULL;
+        return false;
+    }
+    if (memcmp(h->log, HIST_MAGIC, 8)) {
+        fprintf(stderr, "history: %s isn't a sush history\n", h->path);
+        unload(h);
+        return false;
+    }
+
+    uint64_t from = sizeof(struct hist_header);
+    if (load_index(h)) {
+        from = ((const struct index_header *)h->idx)->log_size;
+    }
+    for (uint64_t off = next_record(h->log, from, h->log_len);
+            off < h->log_len; ) {
+        if (h->tail_ct == h->tail_cap) {
+            h->tail_cap = h->tail_cap ? h->tail_cap * 2 : 256;
+            h->tail = realloc(h->tail, h->tail_cap * sizeof(uint64_t));
+            if (h->tail == NULL) {
+                perror("realloc failed in history");
+                exit(-1);
+            }
+        }
+        h->tail[h->tail_ct++] = off;
+        struct hist_record rec;
+        memcpy(&rec, h->log + off, sizeof(rec));
+        off = next_record(h->log, off + sizeof(rec) + rec.len, h->log_len);
+    }
+
+    /* a small tail is cheaper to scan than to index, the index only
+     * gets rebuilt once the tail is a good part of the whole */
+    if (h->tail_ct >= REINDEX_TAIL && h->tail_ct >= h->indexed / 16) {
+        build_index(h);
+    }
+    return true;
+}
+
+/**
+ * maps the index if there is one for this log. returns false if it's
+ * missing or was made from some other file
+ */
+static bool load_index (struct history *h)
+{
+    int fd = open(h->idx_path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &st) < 0
+            || (size_t)st.st_size < sizeof(struct index_header)) {
+        close(fd);
+        return false;
+    }
+    const char *idx = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (idx == MAP_FAILED) {
+        return false;
+    }
+
+    const struct index_header *ih = (const struct index_header *)idx;
+    size_t want = sizeof(*ih) + (size_t)ih->count * 12
+        + (size_t)ih->block_ct * (BLOOM_BITS / 8);
+    if (memcmp(ih->magic, INDEX_MAGIC, 8) || ih->version != HIST_VERSION
+            || ih->log_ino != h->log_ino || ih->log_size > h->log_len
+            || ih->block_ct != (ih->count + BLOCK_ENTRIES - 1) / BLOCK_ENTRIES
+            || (size_t)st.st_size != want) {
+        munmap((void *)idx, st.st_size);
+        return false;
+    }
+    h->idx = idx;
+    h->idx_len = st.st_size;
+    h->indexed = ih->count;
+    h->offsets = (const uint64_t *)(idx + sizeof(*ih));
+    h->sorted = (const uint32_t *)(h->offsets + ih->count);
+    h->blooms = (const uint8_t *)(h->sorted + ih->count);
+    return true;
+}
+
+/**
+ * lets go of everything load() mapped
+ */
+static void unload (struct history *h)
+{
+    if (h->log != NULL) {
+        munmap((void *)h->log, h->log_len);
+    }
+    if (h->idx != NULL) {
+        munmap((void *)h->idx, h->idx_len);
+    }
+    free(h->tail);
+    memset(h, 0, sizeof(*h));
+}
+
+/**
+ * the offset of the first whole record at or after off, or end if
+ * there isn't one. anything that isn't a record, like what is left of
+ * one a crash cut short, is skipped
+ */
+static uint64_t next_record (const char *log, uint64_t off, uint64_t end)
+{
+    const uint32_t magic = REC_MAGIC;
+    while (off + sizeof(struct hist_record) <= end) {
+        struct hist_record rec;
+        memcpy(&rec, log + off, sizeof(rec));
+        if (rec.magic == magic
+                && rec.len <= end - off - sizeof(rec)
+                && fnv1a(log + off + sizeof(rec), rec.len) == rec.sum) {
+            return off;
+        }
+        const char *next = memchr(log + off + 1, ((const char *)&magic)[0],
+                end - off - 1);
+        off = next == NULL ? end : (uint64_t)(next - log);
+    }
+    return end;
+}
+
+/**
+ * the text of entry n, and its length in len
+ */
+static const char *entry_text (struct history *h, uint32_t n, uint32_t *len)
+{
+    uint64_t off = n < h->indexed ? h->offsets[n] : h->tail[n - h->indexed];
+    struct hist_record rec;
+    memcpy(&rec, h->log + off, sizeof(rec));
+    *len = rec.len;
+    return h->log + off + sizeof(rec);
+}
+
+/**
+ * how many lines there are in all
+ */
+static uint32_t entry_count (struct history *h)
+{
+    return h->indexed + h->tail_ct;
+}
+
+/**
+ * writes a new index covering every entry and maps it in place of the
+ * old one. it is written under another name and renamed, so other
+ * shells see either index whole. returns false if it couldn't be
+ */
+static bool build_index (struct history *h)
+{
+    uint32_t ct = entry_count(h);
+    uint32_t block_ct = (ct + BLOCK_ENTRIES - 1) / BLOCK_ENTRIES;
+    size_t size = sizeof(struct index_header) + (size_t)ct * 12
+        + (size_t)block_ct * (BLOOM_BITS / 8);
+    char *buf = calloc(1, size);
+    if (buf == NULL) {
+        return false;
+    }
+
+    struct index_header *ih = (struct index_header *)buf;
+    uint64_t *offsets = (uint64_t *)(buf + sizeof(*ih));
+    uint32_t *sorted = (uint32_t *)(offsets + ct);
+    uint8_t *blooms = (uint8_t *)(sorted + ct);
+    memcpy(ih->magic, INDEX_MAGIC, 8);
+    ih->version = HIST_VERSION;
+    ih->count = ct;
+    ih->log_size = h->log_len;
+    ih->log_ino = h->log_ino;
+    ih->block_ct = block_ct;
+    for (uint32_t i = 0; i < ct; i++) {
+        offsets[i] = i < h->indexed ? h->offsets[i] : h->tail[i - h->indexed];
+        sorted[i] = i;
+        uint32_t len;
+        const char *text = entry_text(h, i, &len);
+        add_trigrams(blooms + (i / BLOCK_ENTRIES) * (BLOOM_BITS / 8),
+                text, len);
+    }
+    sorting = h;
+    qsort(sorted, ct, sizeof(uint32_t), by_text);
+
+    char tmp[PATH_MAX + 16];
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", h->idx_path);
+    int fd = mkstemp(tmp);
+    bool ok = fd >= 0;
+    for (size_t done = 0; ok && done < size;) {
+        ssize_t n = write(fd, buf + done, size - done);
+        ok = n > 0;
+        done += n;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ok && rename(tmp, h->idx_path) == 0) {
+        /* the new index covers the tail now */
+        if (h->idx != NULL) {
+            munmap((void *)h->idx, h->idx_len);
+            h->idx = NULL;
+        }
+        h->indexed = 0;
+        h->tail_ct = 0;
+        ok = load_index(h);
+    } else if (fd >= 0) {
+        unlink(tmp);
+    }
+    free(buf);
+    return ok;
+}
+
+/**
+ * qsort() order of entry numbers by their text, oldest first when the
+ * text is the same
+ */
+static int by_text (const void *a, const void *b)
+{
+    uint32_t na = *(const uint32_t *)a;
+    uint32_t nb = *(const uint32_t *)b;
+    uint32_t la;
+    uint32_t lb;
+    const char *ta = entry_text(sorting, na, &la);
+    const char *tb = entry_text(sorting, nb, &lb);
+    int diff = memcmp(ta, tb, la < lb ? la : lb);
+    if (diff != 0) {
+        return diff;
+    }
+    if (la != lb) {
+        return la < lb ? -1 : 1;
+    }
+    return na < nb ? -1 : na > nb;
+}
+
+/**
+ * qsort() order of entry numbers
+ */
+static int by_number (const void *a, const void *b)
+{
+    uint32_t na = *(const uint32_t *)a;
+    uint32_t nb = *(const uint32_t *)b;
+    return na < nb ? -1 : na > nb;
+}
+
+/**
+ * sets the filter bits for every trigram of text
+ */
+static void add_trigrams (uint8_t *bloom, const char *text, uint32_t len)
+{
+    for (uint32_t i = 0; i + 3 <= len; i++) {
+        unsigned bit = trigram(text + i);
+        bloom[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+/**
+ * false if the block bloom is for can't have a line containing text
+ */
+static bool maybe_has (const uint8_t *bloom, const char *text, size_t len)
+{
+    for (size_t i = 0; i + 3 <= len; i++) {
+        unsigned bit = trigram(text + i);
+        if (!(bloom[bit / 8] & (1 << (bit % 8)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * which filter bit the three bytes at p set
+ */
+static unsigned trigram (const char *p)
+{
+    const unsigned char *u = (const unsigned char *)p;
+    uint32_t v = (uint32_t)u[0] << 16 | (uint32_t)u[1] << 8 | u[2];
+    return (v * 2654435761u) >> 20; // top 12 bits, BLOOM_BITS of them
+}
+
+/**
+ * 32 bit FNV-1a hash, the records' checksum
+ */
+static uint32_t fnv1a (const char *p, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * prints entry n numbered from 1 like history shows it
+ */
+static void print_entry (struct history *h, uint32_t n)
+{
+    uint32_t len;
+    const char *text = entry_text(h, n, &len);
+    printf("%6u  %.*s\n", n + 1, (int)len, text);
+}
+
+/**
+ * prints the lines starting with prefix, oldest first. the index is
+ * binary searched for where they start, only the tail is scanned
+ */
+static void search_prefix (struct history *h, const char *prefix)
+{
+    size_t plen = strlen(prefix);
+    uint32_t lo = 0;
+    uint32_t hi = h->indexed;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t len;
+        const char *text = entry_text(h, h->sorted[mid], &len);
+        int diff = memcmp(text, prefix, len < plen ? len : plen);
+        if (diff < 0 || (diff == 0 && len < plen)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    uint32_t end = lo;
+    while (end < h->indexed) {
+        uint32_t len;
+        const char *text = entry_text(h, h->sorted[end], &len);
+        if (len < plen || memcmp(text, prefix, plen)) {
+            break;
+        }
+        end++;
+    }
+
+    uint32_t *found = malloc((end - lo + 1) * sizeof(uint32_t));
+    if (found == NULL) {
+        perror("malloc failed in history");
+        return;
+    }
+    memcpy(found, h->sorted + lo, (end - lo) * sizeof(uint32_t));
+    qsort(found, end - lo, sizeof(uint32_t), by_number);
+    for (uint32_t i = 0; i < end - lo; i++) {
+        print_entry(h, found[i]);
+    }
+    free(found);
+
+    for (uint32_t n = h->indexed; n < entry_count(h); n++) {
+        uint32_t len;
+        const char *text = entry_text(h, n, &len);
+        if (len >= plen && !memcmp(text, prefix, plen)) {
+            print_entry(h, n);
+        }
+    }
+}
+
+/**
+ * prints the lines with str anywhere in them, oldest first. blocks
+ * whose filter says they can't have it aren't looked at
+ */
+static void search_text (struct history *h, const char *str)
+{
+    size_t slen = strlen(str);
+    uint32_t ct = entry_count(h);
+    for (uint32_t n = 0; n < ct; n++) {
+        if (n < h->indexed && n % BLOCK_ENTRIES == 0
+                && !maybe_has(h->blooms + (n / BLOCK_ENTRIES)
+                    * (BLOOM_BITS / 8), str, slen)) {
+            uint32_t block_end = n + BLOCK_ENTRIES;
+            n = (block_end < h->indexed ? block_end : h->indexed) - 1;
+            continue; // none of this block
+        }
+        uint32_t len;
+        const char *text = entry_text(h, n, &len);
+        if (memmem(text, len, str, slen) != NULL) {
+            print_entry(h, n);
+        }
+    }
+}
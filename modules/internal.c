@@ -6,78 +6,113 @@
  ************************************************
  * Author: Justin Weigle                        *
  *         Richard Bucco                        *
- * Edited: 19 Apr 2020                          *
+ * Edited: 16 Oct 2026                          *
  ************************************************/
 
 #include "../includes/internal.h"
 #include "../includes/sush.h"
+#include "../includes/cmdhash.h"
+#include "../includes/options.h"
+#include "../includes/arena.h"
+#include "../includes/jobs.h"
+#include "../includes/ledger.h"
+#include "../includes/builtins.h"
+#include "../includes/history.h"
+#include "../includes/vars.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <unistd.h>
 
-static bool del_env_var (struct tok_list *);
-static bool set_env_var (struct tok_list *);
-static bool change_directory (struct tok_list *);
-static bool print_wdirectory ();
+static bool exit_shell (int, char **);
+static bool del_env_var (int, char **);
+static bool set_env_var (int, char **);
+static bool export_vars (int, char **);
+static bool list_vars (int, char **);
+static void var_changed (const char *);
+static bool change_directory (int, char **);
+static bool hash_cmd (int, char **);
+static bool set_shell_option (int, char **);
+static bool accounting (int, char **);
+static void print_arena_stats ();
+
+static struct tok_list *current_line = NULL; // for exit to free
 
 /**
  * Runs a given internal command as long as it's
- * valid
+ * valid. Only the first command of the line is looked at
  */
 int run_internal_cmd (struct tok_list *tlist) {
-    bool found_internal_cmd = false;
-    bool err_found = false;
-    if (!strcmp(tlist->head->token, "setenv")) {
-        /* set an environment variable */
-        err_found = set_env_var(tlist);
-        found_internal_cmd = true;
-    } else if (!strcmp(tlist->head->token, "unsetenv")) {
-        /* delete an environment variable */
-        err_found = del_env_var(tlist);
-        found_internal_cmd = true;
-    } else if (!strcmp(tlist->head->token, "cd")) {
-        /* change directory */
-        err_found = change_directory(tlist);
-        found_internal_cmd = true;
-    } else if (!strcmp(tlist->head->token, "pwd")) {
-        /* print the current working directory */
-        print_wdirectory();
-        found_internal_cmd = true;
-    } else if (!strcmp(tlist->head->token, "exit")) {
-        /* print accounting info and exit */
-        free_tok_list(tlist);
-        found_internal_cmd = true;
-        show_all_resources();
-        exit(0);
-    } else if (!strcmp(tlist->head->token, "accnt")) {
-        /* print accounting info */
-        show_all_resources();
-        found_internal_cmd = true;
+    if (tlist->cmd_ct == 0 || tlist->cmds[0].argc == 0) {
+        return 1; // execute() says what is wrong with it
     }
-
-    if (found_internal_cmd) {
-        if (err_found) {
-            return -1; // found, but error
-        } else {
-            return 0; // found, no error
-        }
+    struct builtin *b = find_builtin(tlist->cmds[0].argv[0]);
+    if (b == NULL && tlist->cmd_ct == 1 && tlist->cmds[0].argc == 1
+            && tlist->cmds[0].redir_ct == 0 && !tlist->background
+            && var_assign(tlist->cmds[0].argv[0])) {
+        var_changed(tlist->cmds[0].argv[0]);
+        return 0; // a line that is only NAME=value sets a shell variable
+    }
+    if (b == NULL || b->line == NULL) {
+        return 1; // not found, or runs as a stage in execute()
+    }
+    b->uses++;
+    current_line = tlist;
+    bool err_found = b->line(tlist->cmds[0].argc, tlist->cmds[0].argv);
+    current_line = NULL;
+    if (err_found) {
+        return -1; // found, but error
     } else {
-        return 1; // not found
+        return 0; // found, no error
     }
 }
 
+/**
+ * adds the line builtins to the builtin registry
+ */
+void register_internal_cmds ()
+{
+    add_builtin("setenv", NULL, set_env_var, 0);
+    add_builtin("unsetenv", NULL, del_env_var, 0);
+    add_builtin("export", NULL, export_vars, 0);
+    add_builtin("set", NULL, list_vars, 0);
+    add_builtin("cd", NULL, change_directory, 0);
+    add_builtin("exit", NULL, exit_shell, 0);
+    add_builtin("accnt", NULL, accounting, 0);
+    add_builtin("hash", NULL, hash_cmd, 0);
+    add_builtin("setopt", NULL, set_shell_option, 0);
+    add_builtin("jobs", NULL, jobs_cmd, 0);
+    add_builtin("fg", NULL, fg_cmd, 0);
+    add_builtin("bg", NULL, bg_cmd, 0);
+    add_builtin("wait", NULL, wait_cmd, 0);
+    add_builtin("enable", NULL, enable_cmd, 0);
+    add_builtin("history", NULL, history_cmd, 0);
+}
+
+/**
+ * print accounting info and exit, with the given status or the
+ * last command's
+ */
+static bool exit_shell (int argc, char **argv)
+{
+    int code = argc > 1 ? atoi(argv[1]) : last_status();
+    destroy_tok_list(current_line);
+    show_all_resources();
+    exit(code);
+}
+
 /**
  * Add a new environment variable or modify an existing one
  */
-static bool set_env_var (struct tok_list *tlist)
+static bool set_env_var (int argc, char **argv)
 {
-    if (tlist->count == 3) {
-        if(setenv(tlist->head->next->token, tlist->tail->token, 1)) {
-            perror("couldn't set env var");
+    if (argc == 3) {
+        if (!var_set(argv[1], argv[2], true)) {
+            fprintf(stderr, "setenv: %s isn't a valid name\n", argv[1]);
             return true; // error
         }
+        var_changed(argv[1]);
     } else {
         fprintf(stderr, "setenv takes 2 arguments");
         return true; // error
@@ -86,15 +121,13 @@ static bool set_env_var (struct tok_list *tlist)
 }
 
 /**
- * Delete an environment variable
+ * Delete an environment or shell variable
  */
-static bool del_env_var (struct tok_list *tlist)
+static bool del_env_var (int argc, char **argv)
 {
-    if (tlist->count == 2) {
-        if(unsetenv(tlist->tail->token)) {
-            perror("couldn't delete");
-            return true; // error
-        }
+    if (argc == 2) {
+        var_unset(argv[1]);
+        var_changed(argv[1]);
     } else {
         fprintf(stderr, "unsetenv takes 1 argument");
         return true; // error
@@ -102,22 +135,81 @@ static bool del_env_var (struct tok_list *tlist)
     return false; // no error
 }
 
+/**
+ * export                 list the exported variables
+ * export NAME ...        pass shell variables on to commands
+ * export NAME=value ...  set and export in one go
+ */
+static bool export_vars (int argc, char **argv)
+{
+    if (argc == 1) {
+        var_print(true);
+        return false; // no error
+    }
+    bool err = false;
+    for (int i = 1; i < argc; i++) {
+        char *eq = strchr(argv[i], '=');
+        bool ok;
+        if (eq != NULL) {
+            *eq = '\0';
+            ok = var_set(argv[i], eq + 1, true);
+        } else {
+            ok = var_name_ok(argv[i], strlen(argv[i])) && var_export(argv[i]);
+        }
+        if (!ok) {
+            fprintf(stderr, "export: %s isn't a valid name or isn't set\n",
+                    argv[i]);
+            err = true;
+        } else {
+            var_changed(argv[i]);
+        }
+    }
+    return err;
+}
+
+/**
+ * set    list every variable, exported or not
+ */
+static bool list_vars (int argc, char **argv)
+{
+    if (argc != 1) {
+        fprintf(stderr, "set takes no arguments, use NAME=value\n");
+        return true; // error
+    }
+    var_print(false);
+    return false; // no error
+}
+
+/**
+ * what has to be redone after a variable has changed. word is the
+ * name, or a NAME=value
+ */
+static void var_changed (const char *word)
+{
+    if (!strncmp(word, "PATH", 4) && (word[4] == '\0' || word[4] == '=')) {
+        cmd_hash_forget(); // remembered locations may be wrong now
+    }
+}
+
 /**
  * change to a give directory.
  * ~ == HOME
  */
-static bool change_directory (struct tok_list *tlist)
+static bool change_directory (int argc, char **argv)
 {
-    if (tlist->count == 2) {
-        if ((tlist->head->next->token)[0] == '~') {
-            const char *home = getenv("HOME");
+    if (argc == 2) {
+        if (argv[1][0] == '~') {
+            const char *home = var_get("HOME");
+            if (home == NULL) {
+                home = "";
+            }
             char tmpstr[strlen(home)+1];
             strcpy(tmpstr, home);
-            const char *fpath = strcat(tmpstr, &(tlist->tail->token)[1]);
+            const char *fpath = strcat(tmpstr, &argv[1][1]);
             chdir(fpath);
             return false; // no error
         }
-        chdir(tlist->tail->token);
+        chdir(argv[1]);
     } else {
         fprintf(stderr, "cd takes 1 argument\n");
         return true; // error
@@ -126,15 +218,95 @@ static bool change_directory (struct tok_list *tlist)
 }
 
 /**
- * print the current working directory to STDOUT
+ * hash            list remembered commands and their hit counts
+ * hash -l         list them as reusable hash -p commands
+ * hash -r         forget every remembered command
+ * hash -p path n  remember path as the location of n
+ * hash name ...   look up and remember each name
  */
-static bool print_wdirectory ()
+static bool hash_cmd (int argc, char **argv)
 {
-    char buff[BUFF_SIZE];
-    if (getcwd(buff, BUFF_SIZE) == NULL) {
-        perror("couldn't get current working directory");
+    if (argc == 1) {
+        cmd_hash_print(false);
+        return false; // no error
+    }
+    if (!strcmp(argv[1], "-l")) {
+        cmd_hash_print(true);
+        return false; // no error
+    }
+    if (!strcmp(argv[1], "-r")) {
+        cmd_hash_forget();
+        return false; // no error
+    }
+    if (!strcmp(argv[1], "-p")) {
+        if (argc != 4) {
+            fprintf(stderr, "hash -p takes a path and a name\n");
+            return true; // error
+        }
+        cmd_hash_set(argv[3], argv[2]);
+        return false; // no error
+    }
+
+    bool err = false;
+    for (int i = 1; i < argc; i++) {
+        if (cmd_lookup(argv[i]) == NULL) {
+            fprintf(stderr, "hash: %s not found\n", argv[i]);
+            err = true;
+        }
+    }
+    return err;
+}
+
+/**
+ * setopt               list every option
+ * setopt name value    change an option
+ */
+static bool set_shell_option (int argc, char **argv)
+{
+    if (argc == 1) {
+        print_options();
+        return false; // no error
+    }
+    if (argc != 3) {
+        fprintf(stderr, "setopt takes an option name and a value\n");
+        return true; // error
+    }
+    return set_option(argv[1], argv[2]);
+}
+
+/**
+ * accnt            totals, allocator stats and a table per command
+ * accnt --json     every stage run so far and per command totals
+ * accnt --csv      the same as CSV
+ */
+static bool accounting (int argc, char **argv)
+{
+    if (argc == 1) {
+        show_all_resources();
+        print_arena_stats();
+        ledger_print(LEDGER_TEXT);
+    } else if (argc == 2 && !strcmp(argv[1], "--json")) {
+        ledger_print(LEDGER_JSON);
+    } else if (argc == 2 && !strcmp(argv[1], "--csv")) {
+        ledger_print(LEDGER_CSV);
+    } else {
+        fprintf(stderr, "accnt takes --json or --csv\n");
         return true; // error
     }
-    printf("%s\n", buff);
     return false; // no error
 }
+
+/**
+ * print how much work the tokenizer's allocator has done
+ */
+static void print_arena_stats ()
+{
+    struct arena_stats st;
+    arena_get_stats(&st);
+    printf("arena_allocs     %lu\n", st.allocs);
+    printf("arena_mallocs    %lu\n", st.mallocs);
+    printf("arena_frees      %lu\n", st.frees);
+    printf("arena_resets     %lu\n", st.resets);
+    printf("arena_highwater  %zu\n", st.high_water);
+    printf("\n");
+}
@@ -0,0 +1,577 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                   jobs.c                     *
+ ************************************************
+ * Keeps track of every command line the shell  *
+ * has started, in the foreground or with &.    *
+ * Children are reaped when a signalfd says     *
+ * SIGCHLD came in, never from a handler        *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/jobs.h"
+#include "../includes/sush.h"
+#include "../includes/timing.h"
+#include "../includes/ledger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/signalfd.h>
+
+enum JOB_STATE {
+    JOB_RUNNING,
+    JOB_STOPPED,
+    JOB_DONE
+};
+
+struct stage {
+    pid_t pid;      // -1 if it never started
+    char *name;     // argv[0], for the ledger
+    bool running;   // hasn't exited yet
+    bool stopped;
+};
+
+struct job {
+    int id;
+    int line;       // the ledger's number for the line
+    long long start; // CLOCK_MONOTONIC ns when its stages were started
+    pid_t pgid;     // 0 without job control
+    struct stage *stages;
+    int stage_ct;
+    int left;       // stages that haven't exited
+    int stopped;    // stages that are stopped
+    int status;     // exit status of the last stage
+    enum JOB_STATE state;
+    char *text;     // the line that started it, for jobs
+    struct stage_time *times; // where to record each stage's cost, or NULL
+    struct job *next;
+};
+
+static struct job *jobs = NULL; // oldest first
+static int sig_fd = -1;
+static bool interactive = false;
+static bool control = false;    // process groups and the terminal are ours
+static pid_t shell_pgid;
+static sigset_t child_mask;     // signal mask children start with
+
+static int wait_job (struct job *, bool);
+static void continue_job (struct job *);
+static struct job *find_job (const char *, bool);
+static void remove_job (struct job *);
+static void print_job (struct job *, bool);
+static char *line_text (struct tok_list *);
+
+/**
+ * blocks SIGCHLD and opens a signalfd for it so children are only
+ * ever reaped from the main loop. an interactive shell also takes
+ * charge of the terminal so jobs can be stopped and moved between
+ * the foreground and the background
+ */
+void jobs_init (bool is_interactive)
+{
+    interactive = is_interactive;
+
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &chld, &child_mask);
+    sig_fd = signalfd(-1, &chld, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sig_fd < 0) {
+        perror("signalfd failed in jobs_init()"); // reap at prompts only
+    }
+
+    if (interactive && tcgetpgrp(STDIN_FILENO) >= 0) {
+        signal(SIGTSTP, SIG_IGN);
+        signal(SIGTTIN, SIG_IGN);
+        signal(SIGTTOU, SIG_IGN);
+        setpgid(0, 0); // fails harmlessly if we already lead a group
+        shell_pgid = getpgrp();
+        control = tcsetpgrp(STDIN_FILENO, shell_pgid) == 0;
+    }
+}
+
+/**
+ * true if each job gets its own process group and the terminal
+ */
+bool job_control ()
+{
+    return control;
+}
+
+/**
+ * the signal mask the shell had before SIGCHLD was blocked, which
+ * is what children should run with
+ */
+const sigset_t *jobs_child_mask ()
+{
+    return &child_mask;
+}
+
+/**
+ * adds the stages of a line that were just started, at start, to the
+ * job table as ledger line number line. a stage that couldn't start
+ * has a pid of -1 and one that ran in the shell itself a pid of 0,
+ * which is in the ledger already. a background job is left
+ * running, a foreground one is waited for and its exit status
+ * returned, 127 if the last stage never started
+ */
+int jobs_launch (struct tok_list *tlist, pid_t *pids, int stage_ct, pid_t pgid,
+        long long start, int line)
+{
+    struct job *job = calloc(1, sizeof(struct job));
+    struct stage *stages = calloc(stage_ct, sizeof(struct stage));
+    if (job == NULL || stages == NULL) {
+        perror("calloc failed in jobs_launch()");
+        exit(-1);
+    }
+    job->stages = stages;
+    job->pgid = pgid;
+    job->stage_ct = stage_ct;
+    job->status = 127;
+    job->state = JOB_RUNNING;
+    job->times = tlist->times;
+    job->start = start;
+    pid_t last = -1;
+    for (int i = 0; i < stage_ct; i++) {
+        if (job->times != NULL && pids[i] != 0) {
+            job->times[i].pid = pids[i]; // the shell filled in its own
+        }
+        job->stages[i].pid = pids[i];
+        job->stages[i].running = pids[i] > 0;
+        if (pids[i] > 0) {
+            job->left++;
+            last = pids[i];
+        }
+    }
+    if (job->left == 0) { // nothing started
+        free(job->stages);
+        free(job);
+        return 127;
+    }
+    job->text = line_text(tlist);
+    job->line = line;
+    for (int i = 0; i < stage_ct; i++) {
+        job->stages[i].name = strdup(tlist->cmds[i].argv[0]);
+    }
+
+    /* ids count up from the newest job still around */
+    job->id = 1;
+    struct job **tail = &jobs;
+    while (*tail != NULL) {
+        job->id = (*tail)->id + 1;
+        tail = &(*tail)->next;
+    }
+    *tail = job;
+
+    if (tlist->background) {
+        if (interactive) {
+            printf("[%d] %d\n", job->id, last);
+        }
+        return 0;
+    }
+    return wait_job(job, true);
+}
+
+/**
+ * records that a child was reaped, stopped or continued. returns
+ * false if the pid isn't part of any job, so whoever reaped it is
+ * left to deal with it
+ */
+bool jobs_child_changed (pid_t pid, int status, struct rusage *ruse)
+{
+    for (struct job *job = jobs; job != NULL; job = job->next) {
+        for (int i = 0; i < job->stage_ct; i++) {
+            struct stage *st = &job->stages[i];
+            if (st->pid != pid || !st->running) {
+                continue;
+            }
+            if (WIFSTOPPED(status)) {
+                if (!st->stopped) {
+                    st->stopped = true;
+                    job->stopped++;
+                }
+                job->status = 128 + WSTOPSIG(status);
+            } else if (WIFCONTINUED(status)) {
+                if (st->stopped) {
+                    st->stopped = false;
+                    job->stopped--;
+                }
+                job->state = JOB_RUNNING;
+            } else {
+                if (st->stopped) {
+                    job->stopped--;
+                }
+                st->running = false;
+                st->stopped = false;
+                job->left--;
+                long long end = monotonic_ns();
+                manage_rusage(UPDATE, *ruse);
+                ledger_add(job->line, i+1, st->name, pid, job->start, end,
+                        exit_status(status), ruse);
+                if (job->times != NULL) {
+                    job->times[i].end_ns = end;
+                    job->times[i].ruse = *ruse;
+                }
+                if (i == job->stage_ct-1) {
+                    job->status = exit_status(status);
+                }
+            }
+
+            if (job->left == 0) {
+                job->state = JOB_DONE;
+            } else if (job->stopped == job->left) {
+                job->state = JOB_STOPPED;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * reaps every child that has changed state without blocking. returns
+ * true if a SIGCHLD had come in since the last call
+ */
+bool jobs_reap ()
+{
+    bool signaled = false;
+    struct signalfd_siginfo info;
+    while (sig_fd >= 0 && read(sig_fd, &info, sizeof(info)) == sizeof(info)) {
+        signaled = true;
+    }
+
+    int status;
+    struct rusage ruse;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED | WCONTINUED,
+                    &ruse)) > 0) {
+        if (!jobs_child_changed(pid, status, &ruse)
+                && !WIFSTOPPED(status) && !WIFCONTINUED(status)) {
+            manage_rusage(UPDATE, ruse); // not ours, still count it
+        }
+    }
+    return signaled;
+}
+
+/**
+ * waits for fd to have input without blocking child reaping. returns
+ * true once fd is readable, false if children need to be reaped first
+ */
+bool jobs_wait_input (int fd)
+{
+    if (sig_fd < 0) {
+        return true; // read() will block, reaping waits for the prompt
+    }
+    struct pollfd fds[2] = {
+        { fd, POLLIN, 0 },
+        { sig_fd, POLLIN, 0 }
+    };
+    while (poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) {
+            perror("poll failed in jobs_wait_input()");
+            return true;
+        }
+    }
+    return fds[0].revents != 0 || fds[1].revents == 0;
+}
+
+/**
+ * says which background jobs have finished since the last prompt and
+ * forgets them. only an interactive shell says anything
+ */
+void jobs_notify ()
+{
+    struct job *job = jobs;
+    while (job != NULL) {
+        struct job *next = job->next;
+        if (job->state == JOB_DONE) {
+            if (interactive) {
+                print_job(job, false);
+            }
+            remove_job(job);
+        }
+        job = next;
+    }
+}
+
+/**
+ * turns a status from wait4() into a shell exit status
+ */
+int exit_status (int status)
+{
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return 1;
+}
+
+/**
+ * jobs         list every job
+ * jobs -l      list them with their process ids
+ */
+bool jobs_cmd (int argc, char **argv)
+{
+    bool pids = argc > 1 && !strcmp(argv[1], "-l");
+    if (argc > 2 || (argc == 2 && !pids)) {
+        fprintf(stderr, "jobs takes only -l\n");
+        return true; // error
+    }
+    struct job *job = jobs;
+    while (job != NULL) {
+        struct job *next = job->next;
+        print_job(job, pids);
+        if (job->state == JOB_DONE) {
+            remove_job(job); // been reported now
+        }
+        job = next;
+    }
+    return false; // no error
+}
+
+/**
+ * fg [%n]  continue a job in the foreground and wait for it
+ */
+bool fg_cmd (int argc, char **argv)
+{
+    struct job *job = find_job(argc > 1 ? argv[1] : NULL, false);
+    if (job == NULL) {
+        fprintf(stderr, "fg: no such job\n");
+        return true; // error
+    }
+    printf("%s\n", job->text);
+    if (control && job->pgid > 0) {
+        tcsetpgrp(STDIN_FILENO, job->pgid); // before it can read
+    }
+    continue_job(job);
+    wait_job(job, true);
+    return false; // no error
+}
+
+/**
+ * bg [%n]  continue a stopped job in the background
+ */
+bool bg_cmd (int argc, char **argv)
+{
+    struct job *job = find_job(argc > 1 ? argv[1] : NULL, false);
+    if (job == NULL) {
+        fprintf(stderr, "bg: no such job\n");
+        return true; // error
+    }
+    continue_job(job);
+    printf("[%d] %s &\n", job->id, job->text);
+    return false; // no error
+}
+
+/**
+ * wait             wait for every running job to finish
+ * wait %n|pid ...  wait for the given jobs
+ */
+bool wait_cmd (int argc, char **argv)
+{
+    if (argc == 1) {
+        struct job *job = jobs;
+        while (job != NULL) {
+            struct job *next = job->next;
+            if (job->state != JOB_STOPPED) {
+                wait_job(job, false);
+            }
+            job = next;
+        }
+        return false; // no error
+    }
+
+    bool err = false;
+    for (int i = 1; i < argc; i++) {
+        struct job *job = find_job(argv[i], true);
+        if (job == NULL) {
+            fprintf(stderr, "wait: %s is not a job\n", argv[i]);
+            err = true;
+        } else {
+            wait_job(job, false);
+        }
+    }
+    return err;
+}
+
+/**
+ * blocks until every stage of the job has exited or stopped. a job
+ * in the foreground gets the terminal while it runs. a finished job
+ * is forgotten. returns the job's exit status
+ */
+static int wait_job (struct job *job, bool foreground)
+{
+    if (foreground && control && job->pgid > 0) {
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    }
+    while (job->state == JOB_RUNNING) {
+        int status;
+        struct rusage ruse;
+        pid_t pid = wait4(-1, &status, WUNTRACED, &ruse);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait4 failed");
+            break;
+        }
+        if (!jobs_child_changed(pid, status, &ruse) && !WIFSTOPPED(status)) {
+            manage_rusage(UPDATE, ruse);
+        }
+    }
+    if (foreground && control) {
+        tcsetpgrp(STDIN_FILENO, shell_pgid);
+    }
+
+    int status = job->status;
+    if (job->state == JOB_STOPPED) {
+        job->times = NULL; // whoever was timing it has stopped waiting
+        if (foreground) {
+            printf("\n");
+            print_job(job, false);
+        }
+    } else if (job->state == JOB_DONE) {
+        remove_job(job);
+    }
+    return status;
+}
+
+/**
+ * sends SIGCONT to every stage of a job that hasn't exited
+ */
+static void continue_job (struct job *job)
+{
+    if (job->pgid > 0) {
+        kill(-job->pgid, SIGCONT);
+    } else {
+        for (int i = 0; i < job->stage_ct; i++) {
+            if (job->stages[i].running) {
+                kill(job->stages[i].pid, SIGCONT);
+            }
+        }
+    }
+    for (int i = 0; i < job->stage_ct; i++) {
+        job->stages[i].stopped = false;
+    }
+    job->stopped = 0;
+    if (job->state == JOB_STOPPED) {
+        job->state = JOB_RUNNING;
+    }
+}
+
+/**
+ * finds a job by %n, or by n which is a job number or, if by_pid,
+ * the pid of one of its stages. no spec means the newest job
+ */
+static struct job *find_job (const char *spec, bool by_pid)
+{
+    struct job *found = NULL;
+    if (spec == NULL) {
+        for (struct job *job = jobs; job != NULL; job = job->next) {
+            found = job;
+        }
+        return found;
+    }
+
+    bool by_id = spec[0] == '%';
+    char *end;
+    long n = strtol(spec + by_id, &end, 10);
+    if (*end != '\0' || end == spec + by_id) {
+        return NULL;
+    }
+    by_pid = by_pid && !by_id;
+    for (struct job *job = jobs; job != NULL; job = job->next) {
+        if (!by_pid && job->id == n) {
+            return job;
+        }
+        for (int i = 0; by_pid && i < job->stage_ct; i++) {
+            if (job->stages[i].pid == n) {
+                return job;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * takes a job out of the table and frees it
+ */
+static void remove_job (struct job *job)
+{
+    for (struct job **link = &jobs; *link != NULL; link = &(*link)->next) {
+        if (*link == job) {
+            *link = job->next;
+            break;
+        }
+    }
+    for (int i = 0; i < job->stage_ct; i++) {
+        free(job->stages[i].name);
+    }
+    free(job->stages);
+    free(job->text);
+    free(job);
+}
+
+/**
+ * one line about a job, the way jobs shows it
+ */
+static void print_job (struct job *job, bool pids)
+{
+    char state[32];
+    if (job->state == JOB_RUNNING) {
+        strcpy(state, "Running");
+    } else if (job->state == JOB_STOPPED) {
+        strcpy(state, "Stopped");
+    } else if (job->status == 0) {
+        strcpy(state, "Done");
+    } else {
+        snprintf(state, sizeof(state), "Exit %d", job->status);
+    }
+    printf("[%d]%c ", job->id, job->next == NULL ? '+' : ' ');
+    if (pids) {
+        printf("%d ", job->stages[0].pid);
+    }
+    printf(" %-22s %s\n", state, job->text);
+}
+
+/**
+ * the tokens of a line put back together, for showing the job
+ */
+static char *line_text (struct tok_list *tlist)
+{
+    size_t len = 1;
+    for (int i = 0; i < tlist->count; i++) {
+        len += strlen(tlist->toks[i].str) + 1;
+    }
+    char *text = malloc(len);
+    if (text == NULL) {
+        perror("malloc failed in line_text()");
+        exit(-1);
+    }
+    char *end = text;
+    for (int i = 0; i < tlist->count; i++) {
+        if (tlist->toks[i].kind == TOK_BG) {
+            continue; // jobs shows running/stopped instead
+        }
+        if (i > 0 && tlist->toks[i-1].kind == TOK_HEREDOC) {
+            continue; // a whole here-doc body is too much to show
+        }
+        if (end > text) {
+            *end++ = ' ';
+        }
+        size_t n = strlen(tlist->toks[i].str);
+        memcpy(end, tlist->toks[i].str, n);
+        end += n;
+    }
+    *end = '\0';
+    return text;
+}
@@ -0,0 +1,324 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                  ledger.c                    *
+ ************************************************
+ * Records what every pipeline stage the shell  *
+ * ran cost, and keeps totals per command name  *
+ * so accnt can show which commands are the     *
+ * expensive ones                               *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/ledger.h"
+#include "../includes/hashtab.h"
+#include "../includes/timing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* one stage of one command line */
+struct ledger_entry {
+    int line;           // which command line, counting from 1
+    int stage;          // which stage of it, counting from 1
+    const char *name;   // argv[0], owned by the command's totals
+    pid_t pid;
+    long long start;    // CLOCK_REALTIME ns
+    long long wall;     // ns from start until it was reaped
+    int status;
+    struct rusage ruse;
+};
+
+/* totals for every stage run under one argv[0] */
+struct cmd_totals {
+    const char *name;
+    long count;
+    long long cpu_us;   // user + sys
+    long max_rss;
+    long nvcsw;         // voluntary context switches, mostly pipe waits
+    long nivcsw;        // involuntary ones
+    long long *walls;   // every stage's wall time, for percentiles
+    int wall_cap;
+};
+
+/* what collect_totals() fills in */
+struct totals_list {
+    struct cmd_totals **arr;
+    int ct;
+};
+
+static struct ledger_entry *entries = NULL;
+static int entry_ct = 0;
+static int entry_cap = 0;
+static int line_ct = 0;
+static struct hash_table totals;
+
+static void collect_totals (hash_node *, void *);
+static int by_cpu (const void *, const void *);
+static int by_wall (const void *, const void *);
+static long long percentile (struct cmd_totals *, int);
+static void print_csv_name (const char *);
+static void print_json_name (const char *);
+
+/**
+ * numbers the next command line that runs stages, forked or in the
+ * shell
+ */
+int ledger_new_line ()
+{
+    return ++line_ct;
+}
+
+/**
+ * records a stage that has been reaped. start is when its line was
+ * started and end when it was reaped, both CLOCK_MONOTONIC ns
+ */
+void ledger_add (int line, int stage, const char *name, pid_t pid,
+        long long start, long long end, int status, struct rusage *ruse)
+{
+    struct cmd_totals *tot = ht_get(&totals, name);
+    if (tot == NULL) {
+        tot = calloc(1, sizeof(struct cmd_totals));
+        if (tot == NULL) {
+            perror("calloc failed in ledger_add()");
+            exit(-1);
+        }
+        tot->name = ht_put(&totals, name, tot)->key;
+    }
+
+    if (entry_ct == entry_cap) {
+        entry_cap = entry_cap ? entry_cap * 2 : 64;
+        entries = realloc(entries, entry_cap * sizeof(struct ledger_entry));
+        if (entries == NULL) {
+            perror("realloc failed in ledger_add()");
+            exit(-1);
+        }
+    }
+    if (tot->count == tot->wall_cap) {
+        tot->wall_cap = tot->wall_cap ? tot->wall_cap * 2 : 8;
+        tot->walls = realloc(tot->walls, tot->wall_cap * sizeof(long long));
+        if (tot->walls == NULL) {
+            perror("realloc failed in ledger_add()");
+            exit(-1);
+        }
+    }
+
+    /* the realtime clock of when the line started, for tools that
+     * line stages up with other logs */
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long real_now = now.tv_sec * 1000000000LL + now.tv_nsec;
+
+    struct ledger_entry *e = &entries[entry_ct++];
+    e->line = line;
+    e->stage = stage;
+    e->name = tot->name;
+    e->pid = pid;
+    e->wall = end - start;
+    e->start = real_now - (monotonic_ns() - start);
+    e->status = status;
+    e->ruse = *ruse;
+
+    tot->walls[tot->count++] = e->wall;
+    tot->cpu_us += (ruse->ru_utime.tv_sec + ruse->ru_stime.tv_sec) * 1000000LL
+        + ruse->ru_utime.tv_usec + ruse->ru_stime.tv_usec;
+    if (ruse->ru_maxrss > tot->max_rss) {
+        tot->max_rss = ruse->ru_maxrss;
+    }
+    tot->nvcsw += ruse->ru_nvcsw;
+    tot->nivcsw += ruse->ru_nivcsw;
+}
+
+/**
+ * prints the per command totals, most CPU first. as a table, as JSON
+ * with every stage and the totals, or as CSV with a row per stage
+ * then, after a blank line, a row per command
+ */
+void ledger_print (enum LEDGER_FORMAT format)
+{
+    struct cmd_totals *tots[totals.count + 1];
+    struct totals_list list = { tots, 0 };
+    ht_foreach(&totals, collect_totals, &list);
+    int tot_ct = list.ct;
+    qsort(tots, tot_ct, sizeof(struct cmd_totals *), by_cpu);
+
+    if (format == LEDGER_TEXT) {
+        printf("%-16s %6s %14s %10s %14s %14s %10s %10s\n", "command",
+                "count", "cpu", "maxrss", "wall_p50", "wall_p99", "nvcsw",
+                "nivcsw");
+        for (int i = 0; i < tot_ct; i++) {
+            struct cmd_totals *t = tots[i];
+            long long p50 = percentile(t, 50);
+            long long p99 = percentile(t, 99);
+            printf("%-16s %6ld %7lld.%06lld %10ld %7lld.%06lld %7lld.%06lld"
+                    " %10ld %10ld\n",
+                    t->name, t->count, t->cpu_us / 1000000, t->cpu_us % 1000000,
+                    t->max_rss, p50 / 1000000000, p50 / 1000 % 1000000,
+                    p99 / 1000000000, p99 / 1000 % 1000000, t->nvcsw,
+                    t->nivcsw);
+        }
+        printf("\n");
+        return;
+    }
+
+    if (format == LEDGER_CSV) {
+        printf("line,stage,command,pid,start,end,status,utime,stime,maxrss,"
+                "ixrss,idrss,isrss,minflt,majflt,nswap,inblock,oublock,"
+                "msgsnd,msgrcv,nsignals,nvcsw,nivcsw\n");
+    } else {
+        printf("{\"stages\":[");
+    }
+    for (int i = 0; i < entry_ct; i++) {
+        struct ledger_entry *e = &entries[i];
+        struct rusage *r = &e->ruse;
+        long long end = e->start + e->wall;
+        if (format == LEDGER_CSV) {
+            printf("%d,%d,", e->line, e->stage);
+            print_csv_name(e->name);
+            printf(",%d,%lld.%06lld,%lld.%06lld,%d,%ld.%06ld,%ld.%06ld,%ld,"
+                    "%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld\n",
+                    e->pid, e->start / 1000000000, e->start / 1000 % 1000000,
+                    end / 1000000000, end / 1000 % 1000000, e->status,
+                    r->ru_utime.tv_sec, r->ru_utime.tv_usec,
+                    r->ru_stime.tv_sec, r->ru_stime.tv_usec, r->ru_maxrss,
+                    r->ru_ixrss, r->ru_idrss, r->ru_isrss, r->ru_minflt,
+                    r->ru_majflt, r->ru_nswap, r->ru_inblock, r->ru_oublock,
+                    r->ru_msgsnd, r->ru_msgrcv, r->ru_nsignals, r->ru_nvcsw,
+                    r->ru_nivcsw);
+        } else {
+            printf("%s{\"line\":%d,\"stage\":%d,\"command\":", i ? "," : "",
+                    e->line, e->stage);
+            print_json_name(e->name);
+            printf(",\"pid\":%d,\"start\":%lld.%06lld,\"end\":%lld.%06lld,"
+                    "\"status\":%d,\"utime\":%ld.%06ld,\"stime\":%ld.%06ld,"
+                    "\"maxrss\":%ld,\"ixrss\":%ld,\"idrss\":%ld,\"isrss\":%ld,"
+                    "\"minflt\":%ld,\"majflt\":%ld,\"nswap\":%ld,"
+                    "\"inblock\":%ld,\"oublock\":%ld,\"msgsnd\":%ld,"
+                    "\"msgrcv\":%ld,\"nsignals\":%ld,\"nvcsw\":%ld,"
+                    "\"nivcsw\":%ld}",
+                    e->pid, e->start / 1000000000, e->start / 1000 % 1000000,
+                    end / 1000000000, end / 1000 % 1000000, e->status,
+                    r->ru_utime.tv_sec, r->ru_utime.tv_usec,
+                    r->ru_stime.tv_sec, r->ru_stime.tv_usec, r->ru_maxrss,
+                    r->ru_ixrss, r->ru_idrss, r->ru_isrss, r->ru_minflt,
+                    r->ru_majflt, r->ru_nswap, r->ru_inblock, r->ru_oublock,
+                    r->ru_msgsnd, r->ru_msgrcv, r->ru_nsignals, r->ru_nvcsw,
+                    r->ru_nivcsw);
+        }
+    }
+
+    if (format == LEDGER_CSV) {
+        printf("\ncommand,count,cpu,maxrss,wall_p50,wall_p99,nvcsw,nivcsw\n");
+    } else {
+        printf("],\"commands\":[");
+    }
+    for (int i = 0; i < tot_ct; i++) {
+        struct cmd_totals *t = tots[i];
+        long long p50 = percentile(t, 50);
+        long long p99 = percentile(t, 99);
+        if (format == LEDGER_CSV) {
+            print_csv_name(t->name);
+            printf(",%ld,%lld.%06lld,%ld,%lld.%06lld,%lld.%06lld,%ld,%ld\n",
+                    t->count, t->cpu_us / 1000000, t->cpu_us % 1000000,
+                    t->max_rss, p50 / 1000000000, p50 / 1000 % 1000000,
+                    p99 / 1000000000, p99 / 1000 % 1000000, t->nvcsw,
+                    t->nivcsw);
+        } else {
+            printf("%s{\"command\":", i ? "," : "");
+            print_json_name(t->name);
+            printf(",\"count\":%ld,\"cpu\":%lld.%06lld,\"maxrss\":%ld,"
+                    "\"wall_p50\":%lld.%06lld,\"wall_p99\":%lld.%06lld,"
+                    "\"nvcsw\":%ld,\"nivcsw\":%ld}",
+                    t->count, t->cpu_us / 1000000, t->cpu_us % 1000000,
+                    t->max_rss, p50 / 1000000000, p50 / 1000 % 1000000,
+                    p99 / 1000000000, p99 / 1000 % 1000000, t->nvcsw,
+                    t->nivcsw);
+        }
+    }
+    if (format == LEDGER_JSON) {
+        printf("]}\n");
+    }
+}
+
+/**
+ * ht_foreach() callback that gathers the totals into an array
+ */
+static void collect_totals (hash_node *node, void *arg)
+{
+    struct totals_list *list = arg;
+    list->arr[list->ct++] = node->value;
+}
+
+/**
+ * qsort() order for totals, most CPU time first
+ */
+static int by_cpu (const void *a, const void *b)
+{
+    const struct cmd_totals *x = *(struct cmd_totals * const *)a;
+    const struct cmd_totals *y = *(struct cmd_totals * const *)b;
+    return (x->cpu_us < y->cpu_us) - (x->cpu_us > y->cpu_us);
+}
+
+/**
+ * qsort() order for wall times
+ */
+static int by_wall (const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * the pct percentile of a command's wall times, nearest rank. sorts
+ * the times in place, which is fine since only the set matters
+ */
+static long long percentile (struct cmd_totals *t, int pct)
+{
+    if (t->count == 0) {
+        return 0;
+    }
+    qsort(t->walls, t->count, sizeof(long long), by_wall);
+    long rank = (t->count * pct + 99) / 100; // ceiling
+    return t->walls[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * a command name as a CSV field, quoted if it has to be
+ */
+static void print_csv_name (const char *name)
+{
+    if (strpbrk(name, ",\"\n\r") == NULL) {
+        printf("%s", name);
+        return;
+    }
+    putchar('"');
+    for (const char *c = name; *c; c++) {
+        if (*c == '"') {
+            putchar('"');
+        }
+        putchar(*c);
+    }
+    putchar('"');
+}
+
+/**
+ * a command name as a JSON string
+ */
+static void print_json_name (const char *name)
+{
+    putchar('"');
+    for (const char *c = name; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            printf("\\%c", *c);
+        } else if ((unsigned char)*c < 32) {
+            printf("\\u%04x", *c);
+        } else {
+            putchar(*c);
+        }
+    }
+    putchar('"');
+}
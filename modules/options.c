@@ -0,0 +1,172 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 options.c                    *
+ ************************************************
+ * Shell options that change how SUSH runs      *
+ * commands, set with the setopt builtin        *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/options.h"
+#include "../includes/wildcard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+struct option {
+    const char *name;
+    const char **values; // name of each value, NULL terminated, or
+                         // NULL for a size like 64K or 1M
+    long value;
+    long (*max) ();      // biggest size allowed right now, if limited
+};
+
+static bool parse_size (const char *, long *);
+static void print_size (long);
+static long pipe_max_size ();
+static long glob_max_threads ();
+
+static const char *spawn_values[] = { "fork", "posix", NULL };
+
+static struct option options[OPT_COUNT] = {
+    [OPT_SPAWN] = { "spawn", spawn_values, SPAWN_POSIX, NULL },
+    [OPT_PIPESIZE] = { "pipesize", NULL, 0, pipe_max_size },
+    [OPT_GLOBTHREADS] = { "globthreads", NULL, 0, glob_max_threads },
+};
+
+/**
+ * returns the current value of an option
+ */
+long get_option (enum SUSH_OPT opt)
+{
+    return options[opt].value;
+}
+
+/**
+ * sets the option called name to value. returns true on error
+ */
+bool set_option (const char *name, const char *value)
+{
+    for (int i = 0; i < OPT_COUNT; i++) {
+        if (strcmp(options[i].name, name)) {
+            continue;
+        }
+        if (options[i].values == NULL) {
+            long size;
+            if (!parse_size(value, &size)) {
+                fprintf(stderr, "setopt: %s can't be %s\n", name, value);
+                return true; // error
+            }
+            long max = options[i].max ? options[i].max() : 0;
+            if (max > 0 && size > max) {
+                fprintf(stderr, "setopt: %s is at most %ld\n", name, max);
+                size = max;
+            }
+            options[i].value = size;
+            return false; // no error
+        }
+        for (int v = 0; options[i].values[v] != NULL; v++) {
+            if (!strcmp(options[i].values[v], value)) {
+                options[i].value = v;
+                return false; // no error
+            }
+        }
+        fprintf(stderr, "setopt: %s can't be %s\n", name, value);
+        return true; // error
+    }
+    fprintf(stderr, "setopt: no option called %s\n", name);
+    return true; // error
+}
+
+/**
+ * prints every option and its current value
+ */
+void print_options ()
+{
+    for (int i = 0; i < OPT_COUNT; i++) {
+        printf("%-12s ", options[i].name);
+        if (options[i].values == NULL) {
+            print_size(options[i].value);
+        } else {
+            printf("%s\n", options[i].values[options[i].value]);
+        }
+    }
+}
+
+/**
+ * reads a size like 4096, 64K, 1M or 1G, or "default" for 0. returns
+ * false if it isn't one, or if it is more than an int can hold, since
+ * that is what F_SETPIPE_SZ takes
+ */
+static bool parse_size (const char *str, long *size)
+{
+    if (!strcmp(str, "default")) {
+        *size = 0;
+        return true;
+    }
+    char *end;
+    errno = 0;
+    long n = strtol(str, &end, 10);
+    if (end == str || n < 0 || errno == ERANGE) {
+        return false;
+    }
+    int shift = 0;
+    switch (*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+    }
+    if (n > INT_MAX >> shift) {
+        return false;
+    }
+    *size = n << shift;
+    return *end == '\0';
+}
+
+/**
+ * prints a size the way parse_size() reads it
+ */
+static void print_size (long size)
+{
+    if (size == 0) {
+        printf("default\n");
+    } else if (size % (1 << 30) == 0) {
+        printf("%ldG\n", size >> 30);
+    } else if (size % (1 << 20) == 0) {
+        printf("%ldM\n", size >> 20);
+    } else if (size % (1 << 10) == 0) {
+        printf("%ldK\n", size >> 10);
+    } else {
+        printf("%ld\n", size);
+    }
+}
+
+/**
+ * the most an unprivileged process may grow a pipe to, 0 if unknown
+ */
+static long pipe_max_size ()
+{
+    FILE *f = fopen("/proc/sys/fs/pipe-max-size", "r");
+    long max = 0;
+    if (f != NULL) {
+        if (fscanf(f, "%ld", &max) != 1) {
+            max = 0;
+        }
+        fclose(f);
+    }
+    return max;
+}
+
+/**
+ * the most threads a ** is walked with
+ */
+static long glob_max_threads ()
+{
+    return WILDCARD_MAX_WORKERS;
+}
@@ -0,0 +1,351 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 parallel.c                   *
+ ************************************************
+ * The parallel builtin. Runs a command over a  *
+ * list of items, as many at once as asked for, *
+ * packing items into each command like xargs   *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include "../includes/parallel.h"
+#include "../includes/executor.h"
+#include "../includes/vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* a run of items that go to one command */
+struct batch {
+    int first;
+    int count;
+};
+
+/* a command that is running. its output is held until it exits so
+ * the output of different commands never gets mixed together */
+struct slot {
+    pid_t pid;
+    int out_fd;
+    int err_fd;
+};
+
+static char **read_items (int *, char **);
+static int make_batches (char **, int, char **, int, int, struct batch **);
+static bool start_batch (char **, int, char **, struct batch *, struct slot *);
+static void dump_output (int, int);
+static void usage ();
+
+/**
+ * parallel [-j jobs] [-n max] command [args] [::: item ...]
+ * runs command with the items added to the end of its args, up to
+ * jobs commands at once (one per CPU by default). items are the
+ * words after ::: or else the lines of stdin. each command gets as
+ * many items as ARG_MAX allows, spread so every job has work, or at
+ * most max. returns 0 if every command succeeded, 123 if not
+ */
+int parallel_cmd (int argc, char **argv)
+{
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_items = 0;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "--")) {
+            i++;
+            break;
+        }
+        if ((strcmp(argv[i], "-j") && strcmp(argv[i], "-n")) || i+1 >= argc) {
+            usage();
+            return 2;
+        }
+        int n = atoi(argv[i+1]);
+        if (n < 1) {
+            usage();
+            return 2;
+        }
+        if (argv[i][1] == 'j') {
+            jobs = n;
+        } else {
+            max_items = n;
+        }
+        i++;
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+
+    /* the command is everything up to ::: */
+    char **cmd = argv + i;
+    int cmd_ct = 0;
+    while (i + cmd_ct < argc && strcmp(cmd[cmd_ct], ":::")) {
+        cmd_ct++;
+    }
+    if (cmd_ct == 0) {
+        usage();
+        return 2;
+    }
+
+    char **items;
+    int item_ct;
+    char *input = NULL; // stdin, which the items point into
+    if (i + cmd_ct < argc) {
+        items = cmd + cmd_ct + 1;
+        item_ct = argc - (i + cmd_ct + 1);
+    } else {
+        items = read_items(&item_ct, &input);
+    }
+
+    /* more jobs than items would never have anything to run */
+    if (jobs > item_ct) {
+        jobs = item_ct > 0 ? item_ct : 1;
+    }
+    struct batch *batches;
+    int batch_ct = make_batches(cmd, cmd_ct, items, item_ct,
+            max_items ? max_items : (item_ct + jobs - 1) / jobs, &batches);
+    if (jobs > batch_ct && batch_ct > 0) {
+        jobs = batch_ct;
+    }
+
+    /* the work queue, keep jobs commands running until it's empty */
+    struct slot *slots = calloc(jobs, sizeof(struct slot));
+    if (slots == NULL) {
+        perror("calloc failed in parallel");
+        free(batches);
+        if (input != NULL) {
+            free(items);
+            free(input);
+        }
+        return 1;
+    }
+    int running = 0;
+    int next = 0;
+    int failed = 0;
+    while (next < batch_ct || running > 0) {
+        while (running < jobs && next < batch_ct) {
+            if (start_batch(cmd, cmd_ct, items, &batches[next++],
+                        &slots[running])) {
+                running++;
+            } else {
+                failed++;
+            }
+        }
+        if (running == 0) {
+            break;
+        }
+
+        int status;
+        pid_t pid = wait4(-1, &status, 0, NULL);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("wait4 failed in parallel");
+            break;
+        }
+        for (int s = 0; s < running; s++) {
+            if (slots[s].pid != pid) {
+                continue;
+            }
+            dump_output(slots[s].out_fd, STDOUT_FILENO);
+            dump_output(slots[s].err_fd, STDERR_FILENO);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed++;
+            }
+            slots[s] = slots[--running]; // slot order doesn't matter
+            break;
+        }
+    }
+
+    free(slots);
+    free(batches);
+    if (input != NULL) {
+        free(items);
+        free(input);
+    }
+    return failed ? 123 : 0;
+}
+
+/**
+ * reads stdin to the end and splits it into lines, leaving out empty
+ * ones. the items point into *input, which the caller frees
+ */
+static char **read_items (int *item_ct, char **input)
+{
+    size_t len = 0;
+    size_t cap = 4096;
+    char *buf = malloc(cap);
+    if (buf == NULL) {
+        perror("malloc failed in read_items()");
+        exit(-1);
+    }
+    while (true) {
+        if (len + 1 >= cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+            if (buf == NULL) {
+                perror("realloc failed in read_items()");
+                exit(-1);
+            }
+        }
+        ssize_t n = read(STDIN_FILENO, buf + len, cap - len - 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += n;
+    }
+    buf[len] = '\0';
+
+    int ct = 0;
+    for (size_t c = 0; c < len; c++) {
+        ct += buf[c] == '\n';
+    }
+    char **items = malloc((ct + 1) * sizeof(char *));
+    if (items == NULL) {
+        perror("malloc failed in read_items()");
+        exit(-1);
+    }
+    ct = 0;
+    for (char *line = buf; line < buf + len;) {
+        char *nl = memchr(line, '\n', buf + len - line);
+        char *end = nl ? nl : buf + len;
+        *end = '\0';
+        if (end > line) {
+            items[ct++] = line;
+        }
+        line = end + 1;
+    }
+    *item_ct = ct;
+    *input = buf;
+    return items;
+}
+
+/**
+ * splits the items into runs for each command. a run ends when it
+ * has per_cmd items or one more would push the command's args and
+ * the environment past ARG_MAX, the way xargs packs them
+ */
+static int make_batches (char **cmd, int cmd_ct, char **items, int item_ct,
+        int per_cmd, struct batch **batches)
+{
+    /* execve() counts every string and pointer in argv and envp */
+    long limit = sysconf(_SC_ARG_MAX);
+    if (limit <= 0) {
+        limit = 131072; // the old fixed ARG_MAX
+    }
+    limit -= 2048; // the same headroom xargs leaves
+    for (char **env = var_environ(); *env != NULL; env++) {
+        limit -= strlen(*env) + 1 + sizeof(char *);
+    }
+    long base = sizeof(char *);
+    for (int i = 0; i < cmd_ct; i++) {
+        base += strlen(cmd[i]) + 1 + sizeof(char *);
+    }
+
+    *batches = malloc((item_ct + 1) * sizeof(struct batch));
+    if (*batches == NULL) {
+        perror("malloc failed in make_batches()");
+        exit(-1);
+    }
+    int ct = 0;
+    int i = 0;
+    while (i < item_ct) {
+        struct batch *b = &(*batches)[ct++];
+        b->first = i;
+        b->count = 0;
+        long size = base;
+        while (i < item_ct && b->count < per_cmd) {
+            long item = strlen(items[i]) + 1 + sizeof(char *);
+            if (b->count > 0 && size + item > limit) {
+                break; // too big alone is left for exec to report
+            }
+            size += item;
+            b->count++;
+            i++;
+        }
+    }
+    return ct;
+}
+
+/**
+ * starts the command for one run of items with its output going to
+ * memory. returns false if it couldn't be started
+ */
+static bool start_batch (char **cmd, int cmd_ct, char **items,
+        struct batch *b, struct slot *slot)
+{
+    char **args = malloc((cmd_ct + b->count + 1) * sizeof(char *));
+    if (args == NULL) {
+        perror("malloc failed in start_batch()");
+        exit(-1);
+    }
+    memcpy(args, cmd, cmd_ct * sizeof(char *));
+    memcpy(args + cmd_ct, items + b->first, b->count * sizeof(char *));
+    args[cmd_ct + b->count] = NULL;
+
+    /* stdin is where the items came from, the commands don't get it */
+    int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    slot->out_fd = memfd_create("parallel-out", MFD_CLOEXEC);
+    slot->err_fd = memfd_create("parallel-err", MFD_CLOEXEC);
+    slot->pid = -1;
+    if (null_fd >= 0 && slot->out_fd >= 0 && slot->err_fd >= 0) {
+        slot->pid = spawn_argv(args, null_fd, slot->out_fd, slot->err_fd);
+    } else {
+        perror("parallel couldn't set up a command's output");
+    }
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+    free(args);
+    if (slot->pid < 0) {
+        close(slot->out_fd);
+        close(slot->err_fd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * copies everything a finished command wrote to fd out, then closes
+ * its memory file
+ */
+static void dump_output (int fd, int out)
+{
+    char buf[65536];
+    ssize_t n;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t done = 0; done < n;) {
+            ssize_t w = write(out, buf + done, n - done);
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                close(fd);
+                return; // reader went away
+            }
+            done += w;
+        }
+    }
+    close(fd);
+}
+
+/**
+ * how to use parallel
+ */
+static void usage ()
+{
+    fprintf(stderr, "usage: parallel [-j jobs] [-n max] command [args]"
+            " [::: item ...]\n");
+}
@@ -0,0 +1,68 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 profile.c                    *
+ ************************************************
+ * Times the phases of starting SUSH when it is *
+ * run with --startup-profile, so slow .sushrc  *
+ * lines can be found                           *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/profile.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+static bool enabled = false;
+
+/**
+ * turns on reporting for the rest of startup
+ */
+void profile_enable ()
+{
+    enabled = true;
+}
+
+/**
+ * true if startup is being profiled
+ */
+bool profile_enabled ()
+{
+    return enabled;
+}
+
+/**
+ * monotonic time in nanoseconds, or 0 if profiling is off so
+ * callers don't pay for the clock read
+ */
+long long profile_now ()
+{
+    if (!enabled) {
+        return 0;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * prints how long phase took since start to stderr, followed by a
+ * printf style description of what was being done
+ */
+void profile_report (const char *phase, long long start, const char *fmt, ...)
+{
+    if (!enabled) {
+        return;
+    }
+    long long ns = profile_now() - start;
+    fprintf(stderr, "startup %-10s %6lld.%03lld us  ", phase,
+            ns / 1000, ns % 1000);
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
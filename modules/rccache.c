@@ -0,0 +1,363 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 rccache.c                    *
+ ************************************************
+ * Keeps a compiled copy of the .sushrc so it   *
+ * doesn't have to be tokenized every time the  *
+ * shell starts. The cache is memory mapped and *
+ * its tokens are run straight out of the map   *
+ * as long as the .sushrc hasn't changed        *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/rccache.h"
+#include "../includes/profile.h"
+#include "../includes/vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#define RC_MAGIC "SUSHRC\n"
+
+/* file layout: header, the rc file's path, then records. everything
+ * is padded to 4 bytes so the numbers can be read in place */
+struct rc_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t path_len;
+    uint64_t size;       // of the .sushrc the cache was made from
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint32_t records;
+    uint32_t pad;
+};
+
+enum REC_TYPE {
+    REC_TOKENS = 1, // a tokenized line, run from the map
+    REC_RAW         // text that has to be tokenized again
+};
+
+struct rc_record {
+    uint32_t type;
+    uint32_t count; // tokens for REC_TOKENS, bytes for REC_RAW
+    uint32_t line;  // where the line starts in the .sushrc
+    uint32_t pad;
+};
+
+struct rc_token {
+    uint32_t kind;
+    uint32_t len;   // followed by len bytes and a '\0'
+};
+
+#define PAD4(n) (((n) + 3) & ~(size_t)3)
+
+static bool cache_path (const char *, char *, bool);
+static bool check_records (const char *, size_t, unsigned int);
+static void append (struct rc_cache *, const void *, size_t);
+static void fill_header (struct rc_header *, const char *, struct stat *,
+        unsigned int);
+
+/**
+ * runs the .sushrc from its cache if there is a cache made from the
+ * file as it is now. each line is handed to run along with its line
+ * number in the .sushrc. returns false if the cache is missing or
+ * stale and nothing was run
+ */
+bool rc_cache_run (const char *rcfile, struct stat *st,
+        void (*run)(struct tok_list *, int))
+{
+    char path[PATH_MAX];
+    if (!cache_path(rcfile, path, false)) {
+        return false;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat cst;
+    if (fstat(fd, &cst) < 0 || (size_t)cst.st_size < sizeof(struct rc_header)) {
+        close(fd);
+        return false;
+    }
+    size_t size = cst.st_size;
+    char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    /* the cache has to be for this file, as it is right now */
+    struct rc_header *hdr = (struct rc_header *)map;
+    struct rc_header want;
+    fill_header(&want, rcfile, st, hdr->records);
+    size_t start = sizeof(struct rc_header) + PAD4(want.path_len + 1);
+    if (memcmp(hdr, &want, sizeof(struct rc_header)) || start > size
+            || memcmp(map + sizeof(struct rc_header), rcfile, want.path_len + 1)
+            || !check_records(map + start, size - start, hdr->records)) {
+        munmap(map, size);
+        return false;
+    }
+
+    struct tok_list tlist;
+    init_tok_list(&tlist);
+    char *p = map + start;
+    for (unsigned int r = 0; r < hdr->records; r++) {
+        struct rc_record *rec = (struct rc_record *)p;
+        p += sizeof(struct rc_record);
+        long long start = profile_now();
+        if (rec->type == REC_TOKENS) {
+            for (unsigned int t = 0; t < rec->count; t++) {
+                struct rc_token *tok = (struct rc_token *)p;
+                p += sizeof(struct rc_token);
+                add_token(&tlist, p, tok->kind); // points into the map
+                p += PAD4(tok->len + 1);
+            }
+            finish_tokens(&tlist);
+            profile_report("tokenize", start, "line %u (cached)", rec->line);
+            run(&tlist, rec->line);
+        } else {
+            int used;
+            for (int off = 0; off < (int)rec->count; off += used) {
+                if (tokenize_chunk(&tlist, p + off, rec->count - off, &used)
+                        != TOK_MORE) {
+                    profile_report("tokenize", start, "line %u", rec->line);
+                    run(&tlist, rec->line);
+                }
+            }
+            if (tokenize_pending(&tlist)) { // text ended mid line
+                enum TOK_STATUS ret = tokenize_end(&tlist);
+                profile_report("tokenize", start, "line %u", rec->line);
+                if (ret == TOK_DONE) {
+                    run(&tlist, rec->line);
+                }
+            }
+            p += PAD4(rec->count + 1);
+        }
+        free_tok_list(&tlist);
+    }
+    destroy_tok_list(&tlist);
+    munmap(map, size);
+    return true;
+}
+
+/**
+ * starts an empty cache
+ */
+void rc_cache_init (struct rc_cache *cache)
+{
+    cache->data = NULL;
+    cache->len = 0;
+    cache->cap = 0;
+    cache->records = 0;
+}
+
+/**
+ * adds a tokenized line to the cache
+ */
+void rc_cache_add_tokens (struct rc_cache *cache, struct tok_list *tlist,
+        int line)
+{
+    if (tlist->count == 0) {
+        return; // blank lines don't need to be run again
+    }
+    struct rc_record rec = { REC_TOKENS, tlist->count, line, 0 };
+    append(cache, &rec, sizeof(rec));
+    for (int i = 0; i < tlist->count; i++) {
+        struct rc_token tok = {
+            tlist->toks[i].kind, strlen(tlist->toks[i].str)
+        };
+        append(cache, &tok, sizeof(tok));
+        append(cache, tlist->toks[i].str, tok.len + 1);
+        append(cache, "\0\0\0", PAD4(tok.len + 1) - (tok.len + 1));
+    }
+    cache->records++;
+}
+
+/**
+ * adds text that has to go through the tokenizer every time, like a
+ * line with an error that should be reported every time
+ */
+void rc_cache_add_raw (struct rc_cache *cache, const char *text, int len,
+        int line)
+{
+    struct rc_record rec = { REC_RAW, len, line, 0 };
+    append(cache, &rec, sizeof(rec));
+    append(cache, text, len);
+    append(cache, "\0\0\0\0", PAD4(len + 1) - len);
+    cache->records++;
+}
+
+/**
+ * writes the cache for rcfile, which had the stat st when it was
+ * read. written to a temp file and renamed so other shells starting
+ * at the same time never see half a cache. failing is not an error,
+ * the next shell will just parse the .sushrc again
+ */
+void rc_cache_write (struct rc_cache *cache, const char *rcfile,
+        struct stat *st)
+{
+    char path[PATH_MAX];
+    char tmp[PATH_MAX];
+    if (!cache_path(rcfile, path, true)
+            || snprintf(tmp, PATH_MAX, "%s.%d", path, (int)getpid())
+                >= PATH_MAX) {
+        return;
+    }
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+            S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return;
+    }
+
+    struct rc_header hdr;
+    fill_header(&hdr, rcfile, st, cache->records);
+    size_t path_len = PAD4(hdr.path_len + 1);
+    char *head = calloc(1, sizeof(hdr) + path_len);
+    if (head == NULL) {
+        close(fd);
+        unlink(tmp);
+        return;
+    }
+    memcpy(head, &hdr, sizeof(hdr));
+    memcpy(head + sizeof(hdr), rcfile, hdr.path_len);
+
+    bool ok = write(fd, head, sizeof(hdr) + path_len)
+            == (ssize_t)(sizeof(hdr) + path_len)
+        && write(fd, cache->data, cache->len) == (ssize_t)cache->len;
+    free(head);
+    if (close(fd) < 0 || !ok || rename(tmp, path) < 0) {
+        unlink(tmp);
+    }
+}
+
+/**
+ * gives back the cache's memory
+ */
+void rc_cache_free (struct rc_cache *cache)
+{
+    free(cache->data);
+    rc_cache_init(cache);
+}
+
+/**
+ * where the cache for rcfile lives: $XDG_CACHE_HOME/sush, or
+ * $HOME/.cache/sush, named after a hash of rcfile's path. make
+ * creates the directories if they aren't there
+ */
+static bool cache_path (const char *rcfile, char *path, bool make)
+{
+    char dir[PATH_MAX];
+    const char *xdg = var_get("XDG_CACHE_HOME");
+    const char *home = var_get("HOME");
+    int length;
+    if (xdg != NULL && xdg[0] == '/') {
+        length = snprintf(dir, PATH_MAX, "%s", xdg);
+    } else if (home != NULL) {
+        length = snprintf(dir, PATH_MAX, "%s/.cache", home);
+    } else {
+        return false;
+    }
+    if (length >= PATH_MAX - 6) {
+        return false;
+    }
+    if (make) {
+        mkdir(dir, S_IRWXU);
+    }
+    strcat(dir, "/sush");
+    if (make) {
+        mkdir(dir, S_IRWXU);
+    }
+
+    /* FNV-1a of the path so each rc file gets its own cache */
+    uint64_t hash = 14695981039346656037ull;
+    for (const char *c = rcfile; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 1099511628211ull;
+    }
+    return snprintf(path, PATH_MAX, "%s/rc-%016llx", dir,
+            (unsigned long long)hash) < PATH_MAX;
+}
+
+/**
+ * walks the records once before anything is run, so a truncated or
+ * corrupt cache is thrown out instead of running half of it
+ */
+static bool check_records (const char *p, size_t size, unsigned int records)
+{
+    const char *end = p + size;
+    for (unsigned int r = 0; r < records; r++) {
+        if ((size_t)(end - p) < sizeof(struct rc_record)) {
+            return false;
+        }
+        const struct rc_record *rec = (const struct rc_record *)p;
+        p += sizeof(struct rc_record);
+        if (rec->type == REC_TOKENS) {
+            for (unsigned int t = 0; t < rec->count; t++) {
+                if ((size_t)(end - p) < sizeof(struct rc_token)) {
+                    return false;
+                }
+                const struct rc_token *tok = (const struct rc_token *)p;
+                p += sizeof(struct rc_token);
+                if (tok->kind > TOK_BG || (size_t)(end - p) < PAD4(tok->len + 1)
+                        || p[tok->len] != '\0') {
+                    return false;
+                }
+                p += PAD4(tok->len + 1);
+            }
+        } else if (rec->type == REC_RAW) {
+            if ((size_t)(end - p) < PAD4(rec->count + 1)) {
+                return false;
+            }
+            p += PAD4(rec->count + 1);
+        } else {
+            return false;
+        }
+    }
+    return p == end;
+}
+
+/**
+ * adds bytes to the end of the cache being built
+ */
+static void append (struct rc_cache *cache, const void *data, size_t len)
+{
+    if (cache->len + len > cache->cap) {
+        size_t cap = cache->cap ? cache->cap : 4096;
+        while (cap < cache->len + len) {
+            cap *= 2;
+        }
+        char *bigger = realloc(cache->data, cap);
+        if (bigger == NULL) {
+            perror("realloc failed in append()");
+            exit(-1);
+        }
+        cache->data = bigger;
+        cache->cap = cap;
+    }
+    memcpy(cache->data + cache->len, data, len);
+    cache->len += len;
+}
+
+/**
+ * the header a cache of rcfile with stat st should have
+ */
+static void fill_header (struct rc_header *hdr, const char *rcfile,
+        struct stat *st, unsigned int records)
+{
+    memset(hdr, 0, sizeof(struct rc_header));
+    memcpy(hdr->magic, RC_MAGIC, sizeof(hdr->magic));
+    hdr->version = RC_CACHE_VERSION;
+    hdr->path_len = strlen(rcfile);
+    hdr->size = st->st_size;
+    hdr->mtime_sec = st->st_mtim.tv_sec;
+    hdr->mtime_nsec = st->st_mtim.tv_nsec;
+    hdr->records = records;
+}
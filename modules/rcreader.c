@@ -9,79 +9,180 @@
  ************************************************
  * Author: Justin Weigle                        *
  *         Richard Bucco                        *
- * Edited: 19 Apr 2020                          *
+ * Edited: 16 Oct 2026                          *
  ************************************************/
 
 #include "../includes/rcreader.h"
 #include "../includes/sush.h"
 #include "../includes/executor.h"
 #include "../includes/internal.h"
+#include "../includes/rccache.h"
+#include "../includes/profile.h"
+#include "../includes/vars.h"
+#include "../includes/cmdhash.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <dirent.h>
+#include <errno.h>
 #include <stdbool.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <sys/resource.h>
 
+static void run_rc_file (const char *, int, struct stat *, struct tok_list *);
+static void run_rc_line (struct tok_list *, int);
+
 /**
- * Opens the user's home directory using the $HOME environment
- *  variable and tries to find a .sushrc file that is executable
- *  to parse it into shell commands
+ * Opens $HOME/.sushrc directly and runs it as shell commands as
+ * long as it is executable
  */
 void read_sushrc ()
 {
-    struct tok_list tlist;
-    tlist.head = NULL;
-    tlist.tail = NULL;
-    tlist.count = 0;
-
-    /* set path to home and .sushrc */
-    const char *home = getenv("HOME");
+    long long start = profile_now();
+    const char *home = var_get("HOME");
+    if (home == NULL) {
+        fprintf(stderr, "No .sushrc found...\n");
+        return;
+    }
     // strcat cuts off \0 bit from *dest, need a temp
-    int pathlen = strlen(home);
+    int pathlen = strlen(home) + strlen("/.sushrc");
     char tmpstr[pathlen+1];
     strcpy(tmpstr, home);
     // store full path to .sushrc
     const char *rcfile = strcat(tmpstr, "/.sushrc");
 
-    /* Search for .sushrc in $HOME */
-    DIR *dir;
-    struct dirent *entry;
-    int found = 0;
-    if ((dir = opendir(home)) != NULL) {
-        while ((entry = readdir(dir)) != NULL) {
-            if (!strcmp(entry->d_name, ".sushrc")) {
-                found = 1;
-                // open if executable
-                if (access(rcfile, X_OK) == 0) {
-                    char buf[BUFF_SIZE];
-                    FILE *fp = fopen(rcfile, "r");
-                    // read file until EOF is found (fgets() returns NULL)
-                    while ((fgets(buf, BUFF_SIZE, fp)) != NULL) {
-                        tokenize(&tlist, buf);
-                        if (tlist.head) {
-                            int ret = run_internal_cmd(&tlist);
-                            if (ret < 0) {
-                                fprintf(stderr, "unable to run internal command\n");
-                            } else if (ret == 0) {
-                            } else {
-                                execute(&tlist);
-                            }
-                        }
-                        free_tok_list(&tlist);
-                    }
-                    fclose(fp); // close the file
-                } else {
-                    perror("In read_sushrc() - .sushrc is not executable ");
-                }
-            }
-        }
-        if (!found) {
+    /* go straight to the file, $HOME can be a huge directory */
+    int fd = open(rcfile, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0) {
+        if (errno == ENOENT) {
             fprintf(stderr, "No .sushrc found...\n");
+        } else {
+            perror("In read_sushrc() - could not open .sushrc ");
+        }
+        return;
+    }
+    if (fstat(fd, &st) < 0) {
+        perror("In read_sushrc() - could not stat .sushrc ");
+        close(fd);
+        return;
+    }
+    if (access(rcfile, X_OK) != 0) {
+        perror("In read_sushrc() - .sushrc is not executable ");
+        close(fd);
+        return;
+    }
+    profile_report("rc-find", start, "%s", rcfile);
+
+    struct tok_list tlist;
+    init_tok_list(&tlist);
+    run_rc_file(rcfile, fd, &st, &tlist);
+    destroy_tok_list(&tlist);
+    close(fd);
+}
+
+/**
+ * runs the .sushrc from its cache if the cache is up to date.
+ * otherwise the whole file is read, tokenized and run, and the
+ * tokens are saved as a new cache for the next shell
+ */
+static void run_rc_file (const char *rcfile, int fd, struct stat *st,
+        struct tok_list *tlist)
+{
+    long long start = profile_now();
+    if (rc_cache_run(rcfile, st, run_rc_line)) {
+        profile_report("rc-cache", start, "whole .sushrc from the cache");
+        return;
+    }
+
+    /* read the whole file, a .sushrc is never very big */
+    char *text = malloc(st->st_size + 1);
+    if (text == NULL) {
+        perror("malloc failed in run_rc_file()");
+        exit(-1);
+    }
+    int length = 0;
+    while (length < st->st_size) {
+        int n = read(fd, text + length, st->st_size - length);
+        if (n <= 0) {
+            break;
+        }
+        length += n;
+    }
+
+    /* lines that tokenize are cached as tokens, bad ones as text so
+     * their errors are printed every time. so are lines that used a
+     * variable, which may be different next time */
+    struct rc_cache cache;
+    rc_cache_init(&cache);
+    int line = 0;   // start of the line being tokenized
+    int lineno = 1; // and its line number
+    for (int off = 0, used = 0; off < length; off += used) {
+        start = profile_now();
+        enum TOK_STATUS ret = tokenize_chunk(tlist, text + off, length - off,
+                &used);
+        if (ret == TOK_MORE) {
+            continue;
+        }
+        profile_report("tokenize", start, "line %d", lineno);
+        if (ret == TOK_DONE && !tlist->expanded) {
+            rc_cache_add_tokens(&cache, tlist, lineno);
+        } else {
+            rc_cache_add_raw(&cache, text + line, off + used - line, lineno);
+        }
+        if (ret == TOK_DONE) {
+            run_rc_line(tlist, lineno);
+        }
+        for (; line < off + used; line++) {
+            lineno += text[line] == '\n';
+        }
+    }
+    // last line might not end in a newline
+    start = profile_now();
+    if (tokenize_pending(tlist)) {
+        enum TOK_STATUS ret = tokenize_end(tlist);
+        profile_report("tokenize", start, "line %d", lineno);
+        if (ret == TOK_DONE && !tlist->expanded) {
+            rc_cache_add_tokens(&cache, tlist, lineno);
+        } else {
+            rc_cache_add_raw(&cache, text + line, length - line, lineno);
+        }
+        if (ret == TOK_DONE) {
+            run_rc_line(tlist, lineno);
+        }
+    }
+
+    /* only cache what was read if the file didn't change meanwhile */
+    if (length == st->st_size) {
+        rc_cache_write(&cache, rcfile, st);
+    }
+    rc_cache_free(&cache);
+    free(text);
+}
+
+/**
+ * runs one tokenized line of the .sushrc and empties the list.
+ * lineno is only used to say which line was slow when profiling
+ */
+static void run_rc_line (struct tok_list *tlist, int lineno)
+{
+    if (tlist->count) {
+        long long start = profile_now();
+        cmd_hash_new_line();
+        int ret = run_internal_cmd(tlist);
+        if (ret < 0) {
+            fprintf(stderr, "unable to run internal command\n");
+        }
+        if (ret <= 0) {
+            profile_report("builtin", start, "line %d: %s", lineno,
+                    tlist->cmds[0].argv[0]);
+        } else {
+            start = profile_now(); // don't count the builtin lookup
+            execute(tlist);
+            profile_report("external", start, "line %d: %s", lineno,
+                    tlist->cmds[0].argv[0]);
         }
-        closedir(dir);
-    } else {
-        perror("In read_sushrc() - Could not open $HOME ");
     }
+    free_tok_list(tlist);
 }
@@ -0,0 +1,256 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                  timing.c                    *
+ ************************************************
+ * The time prefix. Runs the rest of the line   *
+ * and reports its wall clock time and rusage   *
+ * for each pipeline stage and the whole line   *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/timing.h"
+#include "../includes/executor.h"
+#include "../includes/internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void add_usage (struct rusage *, struct rusage *);
+static void print_text (struct command *, struct stage_time *, int,
+        long long, struct rusage *);
+static void print_json (struct command *, struct stage_time *, int,
+        long long, struct rusage *, int);
+static void print_tv (struct timeval);
+static void print_ns (long long);
+
+/**
+ * time [--json] line
+ * runs the line after the time prefix and prints what each stage
+ * of it cost to stderr. returns the line's exit status
+ */
+int time_line (struct tok_list *tlist)
+{
+    struct command *first = &tlist->cmds[0];
+    bool json = first->argc > 1 && !strcmp(first->argv[1], "--json");
+    int skip = json ? 2 : 1;
+    if (first->argc <= skip) {
+        fprintf(stderr, "time needs a command to run\n");
+        return 1;
+    }
+    if (tlist->background) {
+        fprintf(stderr, "time can't wait for a background job\n");
+        return 1;
+    }
+
+    /* the line without the prefix */
+    first->argv += skip;
+    first->argc -= skip;
+
+    int stage_ct = tlist->cmd_ct;
+    struct stage_time *times = calloc(stage_ct, sizeof(struct stage_time));
+    if (times == NULL) {
+        perror("calloc failed in time_line()");
+        exit(-1);
+    }
+    for (int i = 0; i < stage_ct; i++) {
+        times[i].pid = -1;
+    }
+
+    int status;
+    long long start = monotonic_ns();
+    struct rusage before;
+    getrusage(RUSAGE_SELF, &before);
+    int ret = run_internal_cmd(tlist);
+    if (ret <= 0) {
+        /* a builtin ran in the shell, it is its own only stage */
+        status = ret < 0 ? 1 : 0;
+        stage_ct = 1;
+        times[0].pid = getpid();
+        times[0].end_ns = monotonic_ns();
+        shell_usage_since(&before, &times[0].ruse);
+    } else {
+        tlist->times = times;
+        status = execute(tlist);
+        tlist->times = NULL;
+    }
+
+    /* the whole line */
+    struct rusage total;
+    memset(&total, 0, sizeof(struct rusage));
+    for (int i = 0; i < stage_ct; i++) {
+        add_usage(&total, &times[i].ruse);
+    }
+
+    if (json) {
+        print_json(tlist->cmds, times, stage_ct, start, &total, status);
+    } else {
+        print_text(tlist->cmds, times, stage_ct, start, &total);
+    }
+
+    free(times);
+    first->argv -= skip;
+    first->argc += skip;
+    return status;
+}
+
+/**
+ * CLOCK_MONOTONIC in nanoseconds
+ */
+long long monotonic_ns ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * what the shell itself has used since before was taken, for a
+ * builtin that ran in it
+ */
+void shell_usage_since (struct rusage *before, struct rusage *used)
+{
+    getrusage(RUSAGE_SELF, used);
+    used->ru_utime.tv_sec -= before->ru_utime.tv_sec;
+    used->ru_utime.tv_usec -= before->ru_utime.tv_usec;
+    used->ru_stime.tv_sec -= before->ru_stime.tv_sec;
+    used->ru_stime.tv_usec -= before->ru_stime.tv_usec;
+    used->ru_minflt -= before->ru_minflt;
+    used->ru_majflt -= before->ru_majflt;
+    used->ru_nvcsw -= before->ru_nvcsw;
+    used->ru_nivcsw -= before->ru_nivcsw;
+    add_usage(used, NULL); // borrow back into tv_usec
+}
+
+/**
+ * adds the counters of add to sum. times are summed, maxrss is the
+ * biggest of the two. tv_usec is carried into tv_sec both ways so
+ * it always stays between 0 and 999999. add can be NULL to only
+ * fix up sum's tv_usec
+ */
+static void add_usage (struct rusage *sum, struct rusage *add)
+{
+    if (add != NULL) {
+        sum->ru_utime.tv_sec += add->ru_utime.tv_sec;
+        sum->ru_utime.tv_usec += add->ru_utime.tv_usec;
+        sum->ru_stime.tv_sec += add->ru_stime.tv_sec;
+        sum->ru_stime.tv_usec += add->ru_stime.tv_usec;
+        if (add->ru_maxrss > sum->ru_maxrss) {
+            sum->ru_maxrss = add->ru_maxrss;
+        }
+        sum->ru_minflt += add->ru_minflt;
+        sum->ru_majflt += add->ru_majflt;
+        sum->ru_nvcsw += add->ru_nvcsw;
+        sum->ru_nivcsw += add->ru_nivcsw;
+    }
+    struct timeval *tvs[2] = { &sum->ru_utime, &sum->ru_stime };
+    for (int i = 0; i < 2; i++) {
+        while (tvs[i]->tv_usec >= 1000000) {
+            tvs[i]->tv_usec -= 1000000;
+            tvs[i]->tv_sec++;
+        }
+        while (tvs[i]->tv_usec < 0) {
+            tvs[i]->tv_usec += 1000000;
+            tvs[i]->tv_sec--;
+        }
+    }
+}
+
+/**
+ * a table with a row per stage and a row for the whole line, whose
+ * wall time ends when its last stage does
+ */
+static void print_text (struct command *cmds, struct stage_time *times,
+        int stage_ct, long long start, struct rusage *total)
+{
+    long long end = start;
+    fprintf(stderr, "\n%5s %8s %12s %12s %12s %9s %8s %8s %8s %8s  %s\n",
+            "stage", "pid", "real", "user", "sys", "maxrss", "minflt",
+            "majflt", "nvcsw", "nivcsw", "command");
+    for (int i = 0; i < stage_ct; i++) {
+        struct stage_time *t = &times[i];
+        struct rusage *ru = &t->ruse;
+        fprintf(stderr, "%5d %8d ", i+1, t->pid);
+        print_ns(t->pid > 0 ? t->end_ns - start : 0);
+        print_tv(ru->ru_utime);
+        print_tv(ru->ru_stime);
+        fprintf(stderr, "%9ld %8ld %8ld %8ld %8ld  %s\n", ru->ru_maxrss,
+                ru->ru_minflt, ru->ru_majflt, ru->ru_nvcsw, ru->ru_nivcsw,
+                cmds[i].argv[0]);
+        if (t->end_ns > end) {
+            end = t->end_ns;
+        }
+    }
+    fprintf(stderr, "%5s %8s ", "all", "");
+    print_ns(end - start);
+    print_tv(total->ru_utime);
+    print_tv(total->ru_stime);
+    fprintf(stderr, "%9ld %8ld %8ld %8ld %8ld\n", total->ru_maxrss,
+            total->ru_minflt, total->ru_majflt, total->ru_nvcsw,
+            total->ru_nivcsw);
+}
+
+/**
+ * the same numbers as one line of JSON, times in seconds
+ */
+static void print_json (struct command *cmds, struct stage_time *times,
+        int stage_ct, long long start, struct rusage *total, int status)
+{
+    long long end = start;
+    fprintf(stderr, "{\"stages\":[");
+    for (int i = 0; i < stage_ct; i++) {
+        struct stage_time *t = &times[i];
+        struct rusage *ru = &t->ruse;
+        long long real = t->pid > 0 ? t->end_ns - start : 0;
+        if (t->end_ns > end) {
+            end = t->end_ns;
+        }
+        fprintf(stderr, "%s{\"command\":\"", i ? "," : "");
+        for (char *c = cmds[i].argv[0]; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                fprintf(stderr, "\\%c", *c);
+            } else if ((unsigned char)*c < 32) {
+                fprintf(stderr, "\\u%04x", *c);
+            } else {
+                fputc(*c, stderr);
+            }
+        }
+        fprintf(stderr, "\",\"pid\":%d,\"real\":%lld.%09lld,"
+                "\"user\":%ld.%06ld,\"sys\":%ld.%06ld,\"maxrss\":%ld,"
+                "\"minflt\":%ld,\"majflt\":%ld,\"nvcsw\":%ld,\"nivcsw\":%ld}",
+                t->pid, real / 1000000000, real % 1000000000,
+                ru->ru_utime.tv_sec, ru->ru_utime.tv_usec,
+                ru->ru_stime.tv_sec, ru->ru_stime.tv_usec, ru->ru_maxrss,
+                ru->ru_minflt, ru->ru_majflt, ru->ru_nvcsw, ru->ru_nivcsw);
+    }
+    long long real = end - start;
+    fprintf(stderr, "],\"status\":%d,\"real\":%lld.%09lld,"
+            "\"user\":%ld.%06ld,\"sys\":%ld.%06ld,\"maxrss\":%ld,"
+            "\"minflt\":%ld,\"majflt\":%ld,\"nvcsw\":%ld,\"nivcsw\":%ld}\n",
+            status, real / 1000000000, real % 1000000000,
+            total->ru_utime.tv_sec, total->ru_utime.tv_usec,
+            total->ru_stime.tv_sec, total->ru_stime.tv_usec, total->ru_maxrss,
+            total->ru_minflt, total->ru_majflt, total->ru_nvcsw,
+            total->ru_nivcsw);
+}
+
+/**
+ * seconds with every microsecond digit, so 1.5s is always 1.500000
+ */
+static void print_tv (struct timeval tv)
+{
+    fprintf(stderr, "%5ld.%06ld ", (long)tv.tv_sec, (long)tv.tv_usec);
+}
+
+/**
+ * nanoseconds as seconds, to the microsecond like print_tv()
+ */
+static void print_ns (long long ns)
+{
+    fprintf(stderr, "%5lld.%06lld ", ns / 1000000000, ns / 1000 % 1000000);
+}
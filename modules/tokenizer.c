@@ -2,21 +2,31 @@
  *       Shippensburg University Shell          *
  *                tokenizer.c                   *
  ************************************************
- * tokenize takes a string as input and then    *
- * separates the string into tokens that can    *
- * further be used to execute shell commands    *
+ * tokenize takes input a chunk at a time and   *
+ * separates it into tokens that can further    *
+ * be used to execute shell commands            *
  ************************************************
  * Author: Justin Weigle                        *
  *         Richard Bucco                        *
- * Edited: 19 Apr 2020                          *
+ * Edited: 16 Oct 2026                          *
  ************************************************/
 
 #include "../includes/tokenizer.h"
+#include "../includes/vars.h"
+#include "../includes/wildcard.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
 
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* the bytes of v that are c, for scan_plain() */
+#define AVX_EQ(v, c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+#define SSE_EQ(v, c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+
 typedef enum {
     Init_State,
     Blank_State,
@@ -24,348 +34,1037 @@ typedef enum {
     Redirect_State,
     Single_Quote_State,
     Double_Quote_State,
+    Single_Escape_State,
+    Double_Escape_State,
+    Init_Escape_State,
+    Blank_Escape_State,
+    Letter_Escape_State,
+    Redirect_Escape_State,
+    Background_State,
+    Heredoc_State,
+    Var_State,          // $NAME or ${NAME} outside quotes
+    Quoted_Var_State,   // and inside double quotes
+    Discard_State,
+    Num_States
 } Token_Sys_State;
 
+/* every input byte falls into one of these classes */
+typedef enum {
+    C_Other,    // anything the shell won't take outside quotes
+    C_Newline,
+    C_Space,
+    C_Dquote,
+    C_Squote,
+    C_Backslash,
+    C_Less,
+    C_Greater,
+    C_Pipe,
+    C_Amp,
+    C_Dollar,
+    C_Glob,     // * ? [
+    C_Print,    // everything else from 32 to 127
+    Num_Classes
+} Char_Class;
+
+/* what to do with a byte before moving to the next state */
+typedef enum {
+    A_None,
+    A_End,          // newline ends the line
+    A_Save_End,     // save the word built so far, newline ends the line
+    A_Append,       // add byte to the token
+    A_Save,         // save the word built so far
+    A_Save_Op,      // save the redirect or pipe built so far
+    A_Save_Start,   // save word, byte starts a redirect or pipe
+    A_Op_Start,     // save redirect or pipe, byte starts a word
+    A_Greater,      // second > of >>, or an error
+    A_Less,         // more < of << or <<<, or an error
+    A_Escape,       // byte after a \ in quotes
+    A_Unescape,     // \ wasn't before a newline, keep it and redo byte
+    A_Op_Unescape,  // same, but a redirect or pipe has to be saved first
+    A_Discard_End,  // newline ends a line that had an error
+    A_Background,   // save any word, then & runs the line in the background
+    A_Var_Start,    // $ starts a variable, read by var_byte()
+    A_Op_Var,       // save redirect or pipe, $ starts a variable
+    A_Glob,         // add a wildcard to the token, it is a pattern now
+    A_Literal,      // add a quoted wildcard, which only matches itself
+    E_Need_Input,
+    E_Unrecognized,
+    E_Redirect_End,
+    E_Not_Valid,
+    E_Not_Last
+} Token_Action;
+
+struct transition {
+    unsigned char next;
+    unsigned char action;
+};
+
+#define ROW(nl, sp, dq, sq, bs, lt, gt, pi, am, dl, gb, pr, ot) \
+    { [C_Newline] = nl, [C_Space] = sp, [C_Dquote] = dq, [C_Squote] = sq, \
+      [C_Backslash] = bs, [C_Less] = lt, [C_Greater] = gt, [C_Pipe] = pi, \
+      [C_Amp] = am, [C_Dollar] = dl, [C_Glob] = gb, [C_Print] = pr, \
+      [C_Other] = ot }
+#define T(state, action) { state, action }
+#define NL_OR(nl_state, nl_action, state, action) \
+    ROW(T(nl_state, nl_action), T(state, action), T(state, action), \
+        T(state, action), T(state, action), T(state, action), \
+        T(state, action), T(state, action), T(state, action), \
+        T(state, action), T(state, action), T(state, action), \
+        T(state, action))
+/* outside quotes \$ is a plain $ and \* a plain *, any other \ stays
+ * in the word */
+#define UNESCAPE(nl_state, state, action) \
+    ROW(T(nl_state, A_None), T(state, action), T(state, action), \
+        T(state, action), T(state, action), T(state, action), \
+        T(state, action), T(state, action), T(state, action), \
+        T(Letter_State, A_Append), T(Letter_State, A_Literal), \
+        T(state, action), T(state, action))
+
+/* the tokenizer's state machine, indexed by state and then by class.
+ * a backslash right before a newline joins two lines in every state,
+ * and quotes may span lines */
+static const struct transition dfa[Num_States][Num_Classes] = {
+    [Init_State] = ROW(
+        T(Init_State, A_End),           T(Init_State, A_None),
+        T(Double_Quote_State, A_None),  T(Single_Quote_State, A_None),
+        T(Init_Escape_State, A_None),   T(Init_State, E_Need_Input),
+        T(Init_State, E_Need_Input),    T(Init_State, E_Need_Input),
+        T(Init_State, E_Need_Input),    T(Var_State, A_Var_Start),
+        T(Letter_State, A_Glob),
+        T(Letter_State, A_Append),      T(Init_State, E_Unrecognized)),
+    [Letter_State] = ROW(
+        T(Init_State, A_Save_End),      T(Blank_State, A_Save),
+        T(Double_Quote_State, A_None),  T(Single_Quote_State, A_None),
+        T(Letter_Escape_State, A_None), T(Redirect_State, A_Save_Start),
+        T(Redirect_State, A_Save_Start), T(Redirect_State, A_Save_Start),
+        T(Background_State, A_Background), T(Var_State, A_Var_Start),
+        T(Letter_State, A_Glob),
+        T(Letter_State, A_Append),      T(Letter_State, E_Unrecognized)),
+    [Blank_State] = ROW(
+        T(Init_State, A_End),           T(Blank_State, A_None),
+        T(Double_Quote_State, A_None),  T(Single_Quote_State, A_None),
+        T(Blank_Escape_State, A_None),  T(Redirect_State, A_Append),
+        T(Redirect_State, A_Append),    T(Redirect_State, A_Append),
+        T(Background_State, A_Background), T(Var_State, A_Var_Start),
+        T(Letter_State, A_Glob),
+        T(Letter_State, A_Append),      T(Blank_State, E_Unrecognized)),
+    [Redirect_State] = ROW(
+        T(Redirect_State, E_Redirect_End), T(Redirect_State, A_None),
+        T(Double_Quote_State, A_Save_Op), T(Single_Quote_State, A_Save_Op),
+        T(Redirect_Escape_State, A_None), T(Redirect_State, A_Less),
+        T(Redirect_State, A_Greater),   T(Redirect_State, E_Not_Valid),
+        T(Redirect_State, E_Not_Valid), T(Var_State, A_Op_Var),
+        T(Letter_State, A_Op_Start),    /* files aren't patterns */
+        T(Letter_State, A_Op_Start),    T(Redirect_State, E_Unrecognized)),
+    /* a closing quote goes to Letter_State, which treats the next byte
+     * the same way the quote states used to when they peeked at it */
+    [Single_Quote_State] = ROW(
+        T(Single_Quote_State, A_Append),
+        T(Single_Quote_State, A_Append), T(Single_Quote_State, A_Append),
+        T(Letter_State, A_None),        T(Single_Escape_State, A_None),
+        T(Single_Quote_State, A_Append), T(Single_Quote_State, A_Append),
+        T(Single_Quote_State, A_Append), T(Single_Quote_State, A_Append),
+        T(Single_Quote_State, A_Append), T(Single_Quote_State, A_Literal),
+        T(Single_Quote_State, A_Append), T(Single_Quote_State, A_Append)),
+    [Double_Quote_State] = ROW(
+        T(Double_Quote_State, A_Append),
+        T(Double_Quote_State, A_Append), T(Letter_State, A_None),
+        T(Double_Quote_State, A_Append), T(Double_Escape_State, A_None),
+        T(Double_Quote_State, A_Append), T(Double_Quote_State, A_Append),
+        T(Double_Quote_State, A_Append), T(Double_Quote_State, A_Append),
+        T(Quoted_Var_State, A_Var_Start), T(Double_Quote_State, A_Literal),
+        T(Double_Quote_State, A_Append), T(Double_Quote_State, A_Append)),
+    [Single_Escape_State] = NL_OR(Single_Quote_State, A_None,
+        Single_Quote_State, A_Escape),
+    [Double_Escape_State] = NL_OR(Double_Quote_State, A_None,
+        Double_Quote_State, A_Escape),
+    [Init_Escape_State] = UNESCAPE(Init_State, Letter_State, A_Unescape),
+    [Blank_Escape_State] = UNESCAPE(Blank_State, Letter_State, A_Unescape),
+    [Letter_Escape_State] = UNESCAPE(Letter_State, Letter_State, A_Unescape),
+    [Redirect_Escape_State] = NL_OR(Redirect_State, A_None,
+        Letter_State, A_Op_Unescape),
+    /* & has to be the last thing on the line */
+    [Background_State] = ROW(
+        T(Init_State, A_End),           T(Background_State, A_None),
+        T(Background_State, E_Not_Last), T(Background_State, E_Not_Last),
+        T(Background_State, E_Not_Last), T(Background_State, E_Not_Last),
+        T(Background_State, E_Not_Last), T(Background_State, E_Not_Last),
+        T(Background_State, E_Not_Last), T(Background_State, E_Not_Last),
+        T(Background_State, E_Not_Last), T(Background_State, E_Not_Last),
+        T(Background_State, E_Not_Last)),
+    /* here-doc bodies are read a line at a time by heredoc_line(),
+     * and variable names a byte at a time by var_byte() */
+    [Discard_State] = NL_OR(Init_State, A_Discard_End,
+        Discard_State, A_None),
+};
+
+static unsigned char char_class[256];
+
+static void init_classes ();
+static size_t scan_plain (const char *, const char *);
+static char escape_char (char);
+static void reserve (struct tok_list *, int);
+static void reset_state (struct tok_list *);
+static bool next_heredoc (struct tok_list *, int);
+static int heredoc_line (struct tok_list *, const char *, int, bool *);
+static void end_heredoc (struct tok_list *);
+static int var_byte (struct tok_list *, char, Token_Sys_State *);
+static void save_word (struct tok_list *, int);
+static void add_literal (struct tok_list *, int);
+static bool glob_word (struct tok_list *, int);
+static void add_match (const char *, void *);
 static void save_string (char*, struct tok_list**, bool);
+static enum TOK_KIND op_kind (char *);
+static void new_command (struct tok_list *);
+static void end_command (struct tok_list *);
+static void push_arg (struct tok_list *, char *);
+static void *grow (void *, int *, int, size_t);
 
 /**
- * Uses state machine to tokenize a user's input into appropriate
- * tokens for processing as shell commands
+ * Uses a table driven state machine to tokenize a chunk of a user's
+ * input into appropriate tokens for processing as shell commands.
+ * Input can be fed in pieces of any size, the state and the token
+ * being built are kept in tlist between calls. Stops after the
+ * newline that ends a line and sets used to how many bytes were
+ * taken, or after the bodies of any here-docs on it. Runs of ordinary
+ * bytes are found with scan_plain() and copied all at once. $NAME and
+ * ${NAME} are replaced by the variable's value as the word is built,
+ * and words with unquoted wildcards by the files they match
  */
-void tokenize (struct tok_list *tlist, char *input)
+enum TOK_STATUS tokenize_chunk (struct tok_list *tlist, const char *input,
+        int length, int *used)
 {
-    int length = strlen(input);
-    if (input[length-1] != '\n') {
-        fprintf(stderr, "Input didn't end in \\n, skipping...\n");
-        return;
-    }
+    init_classes();
 
-    char token[length];
+    const char *end = input + length;
+    Token_Sys_State State = tlist->state;
     char ch;
-    Token_Sys_State State = Init_State;
+    int i = 0;
 
-    for(int i = 0, j = 0; i < length; i++) {
+    while (i < length) {
         ch = input[i];
-        switch (State) {
-            /* Should only change for quotes or letters.
-             * Save ch if letter */
-            case Init_State:
-                if (ch == '\n') {
-                    return;
-                } else if (ch == '"') {
-                    State = Double_Quote_State;
-                } else if (ch == '\'') {
-                    State = Single_Quote_State;
-                } else if (ch == '<' || ch == '>' || ch == '|') {
-                    fprintf(stderr, "Need input before redirect or pipe\n");
-                    return;
-                } else if (ch == ' ') {
-                } else if (32 <= ch && ch <= 127) {
-                    State = Letter_State;
-                    token[j] = ch;
-                    j++;
-                } else {
-                    fprintf(stderr, "Unrecognized character %c\n", ch);
-                    return;
-                }
+
+        if (State == Heredoc_State) {
+            bool ended;
+            i += heredoc_line(tlist, input + i, length - i, &ended);
+            if (ended && !next_heredoc(tlist, tlist->doc_tok)) {
+                goto line_done;
+            }
+            continue;
+        }
+
+        if (State == Var_State || State == Quoted_Var_State) {
+            reserve(tlist, 2);
+            int took = var_byte(tlist, ch, &State);
+            if (took < 0) {
+                goto bad_line;
+            }
+            i += took; // a byte that ended the name is redone
+            continue;
+        }
+
+        /* nothing in a bad line matters until its newline */
+        if (State == Discard_State) {
+            const char *nl = memchr(input + i, '\n', length - i);
+            if (nl == NULL) {
+                i = length;
                 break;
-            /* Change for everything except letters.
-             * Save ch for letters only.
-             * Save string for redirect and newline */
-            case Letter_State:
-                if (ch == '\n') {
-                    token[j] = '\0';
-                    save_string(token, &tlist, false);
-                } else if (ch == '"') {
-                    State = Double_Quote_State;
-                } else if (ch == '\'') {
-                    State = Single_Quote_State;
-                } else if (ch == '<' || ch == '>' || ch == '|') {
-                    State = Redirect_State;
-                    token[j] = '\0';
-                    save_string(token, &tlist, false);
-                    token[0] = ch;
-                    j = 1;
-                } else if (ch == ' ') {
-                    State = Blank_State;
-                    token[j] = '\0';
-                    save_string(token, &tlist, false);
-                    j = 0;
-                } else if (32 <= ch && ch <= 127) {
-                    token[j] = ch;
-                    j++;
-                } else {
-                    fprintf(stderr, "Unrecognized character %c\n", ch);
-                    free_tok_list(tlist);
-                    return;
-                }
+            }
+            i = nl - input;
+            ch = '\n';
+        }
+
+        reserve(tlist, 3); // worst case, an escape and a '\0'
+        char *token = tlist->buf;
+        int j = tlist->buf_len;
+        const struct transition *t = &dfa[State][char_class[(unsigned char)ch]];
+        switch (t->action) {
+            case A_None:
                 break;
-            /* Change for everything except blanks.
-             * Save ch for letters and redirect */
-            case Blank_State:
-                if (ch == '\n') {
-                } else if (ch == '"') {
-                    State = Double_Quote_State;
-                } else if (ch == '\'') {
-                    State = Single_Quote_State;
-                } else if (ch == '<' || ch == '>' || ch == '|') {
-                    State = Redirect_State;
-                    token[j] = ch;
-                    j++;
-                } else if (ch == ' ') {
-                } else if (32 <= ch && ch <= 127) {
-                    State = Letter_State;
-                    token[j] = ch;
-                    j++;
-                } else {
-                    fprintf(stderr, "Unrecognized character %c\n", ch);
-                    free_tok_list(tlist);
-                    return;
+            case A_Save_End:
+                save_word(tlist, j);
+                /* fall through */
+            case A_End:
+                i++;
+                if (next_heredoc(tlist, -1)) {
+                    State = Heredoc_State; // bodies are on the next lines
+                    continue;
                 }
+                goto line_done;
+            case A_Append:
+                token[j++] = ch;
                 break;
-            /* save ch for another > if >.
-             * error on any other redirect or newline
-             * save string and change for anything else
-             * */
-            case Redirect_State:
-                if (ch == '"') {
-                    State = Double_Quote_State;
-                    token[j] = '\0';
-                    save_string(token, &tlist, true);
-                    j = 0;
-                } else if (ch == '\'') {
-                    State = Single_Quote_State;
-                    token[j] = '\0';
-                    save_string(token, &tlist, true);
-                    j = 0;
-                } else if (ch == '\n') {
-                    fprintf(stderr, "Can't have redirect at end of input\n");
-                    free_tok_list(tlist);;
-                    return;
-                } else if (ch == '<' || ch == '|') {
-                    fprintf(stderr, "%c not valid after >\n", ch);
-                    free_tok_list(tlist);;
-                    return;
-                } else if (ch == '>') {
-                    if (input[i-1] == '>') {
-                        if (input[i+1] == '>') {
-                            fprintf(stderr, "Too many redirects in a row\n");
-                            free_tok_list(tlist);;
-                            return;
-                        }
-                        token[j] = ch;
-                        j++;
-                    } else {
-                        fprintf(stderr,
-                            "Cannot have spaces between >\n");
-                        free_tok_list(tlist);;
-                        return;
-                    }
-                } else if (ch == ' ') {
-                } else if (32 <= ch && ch <= 127) {
-                    State = Letter_State;
-                    token[j] = '\0';
-                    save_string(token, &tlist, true);
-                    token[0] = ch;
-                    j = 1;
-                } else {
-                    fprintf(stderr, "Unrecognized character %c\n", ch);
-                    free_tok_list(tlist);;
-                    return;
+            case A_Save:
+                save_word(tlist, j);
+                j = 0;
+                break;
+            case A_Save_Op:
+                token[j] = '\0';
+                save_string(token, &tlist, true);
+                j = 0;
+                break;
+            case A_Save_Start:
+                save_word(tlist, j);
+                token[0] = ch;
+                j = 1;
+                break;
+            case A_Op_Start:
+                token[j] = '\0';
+                save_string(token, &tlist, true);
+                token[0] = ch;
+                j = 1;
+                break;
+            case A_Greater:
+                /* only >> is allowed, and only with nothing between */
+                if (tlist->prev != '>') {
+                    fprintf(stderr, "Cannot have spaces between >\n");
+                    goto bad_line;
+                }
+                if (j > 1) {
+                    fprintf(stderr, "Too many redirects in a row\n");
+                    goto bad_line;
                 }
+                token[j++] = ch;
                 break;
-            /** everything is treated as plaintext until
-             *  the next single quote other than escaped chars.
-             *  After end quote found, check next char to
-             *  decide which state to change to             */
-            case Single_Quote_State:
-                if (ch == '\'') {
-                    i++; // check next character
-                    ch = input[i];
-                    if (ch == '"') {
-                        State = Double_Quote_State;
-                    } else if (ch == '\'') {
-                    } else if (ch == '<' || ch == '>' || ch == '|') {
-                        State = Redirect_State;
-                        token[j] = '\0';
-                        save_string(token, &tlist, false);
-                        token[0] = ch;
-                        j = 1;
-                    } else if (ch == ' ') {
-                        State = Blank_State;
-                        token[j] = '\0';
-                        save_string(token, &tlist, false);
-                        j = 0;
-                    } else if (32 <= ch && ch <= 127) {
-                        State = Letter_State;
-                        token[j] = ch;
-                        j++;
-                    } else if (ch == '\n') {
-                        token[j] = '\0';
-                        save_string(token, &tlist, false);
-                    } else {
-                        fprintf(stderr, "Unrecognized character %c\n", ch);
-                        free_tok_list(tlist);;
-                        return;
-                    }
-                } else if (ch == '\n') {
-                    fprintf(stderr, "Quote never closed \'\n");
-                    free_tok_list(tlist);;
-                    return;
-                } else if (ch == '\\') { // handle escaped characters
-                    i++;
-                    char ec = input[i];
-                    if (ec == 'n') {
-                        token[j++] = '\n';
-                    } else if (ec == 'b') {
-                        token[j++] = '\b';
-                    } else if (ec == 'r') {
-                        token[j++] = '\r';
-                    } else if (ec == 't') {
-                        token[j++] = '\t';
-                    } else if (ec == 'v') {
-                        token[j++] = '\v';
-                    } else if (ec == '0') {
-                        token[j++] = '\0';
-                    } else {
-                        token[j++] = input[i-1];
-                        token[j++] = ec;
-                    }
-                } else {
-                    token[j] = ch;
-                    j++;
+            case A_Less:
+                /* << is a here-doc and <<< a here-string */
+                if (token[0] != '<') {
+                    fprintf(stderr, "< not valid after %c\n", token[0]);
+                    goto bad_line;
                 }
+                if (tlist->prev != '<') {
+                    fprintf(stderr, "Cannot have spaces between <\n");
+                    goto bad_line;
+                }
+                if (j > 2) {
+                    fprintf(stderr, "Too many redirects in a row\n");
+                    goto bad_line;
+                }
+                token[j++] = ch;
                 break;
-            /** see single quote explanation    */
-            case Double_Quote_State:
-                if (ch == '"') {
-                    i++; // check next character
-                    ch = input[i];
-                    if (ch == '\'') {
-                        State = Single_Quote_State;
-                    } else if (ch == '"') {
-                    } else if (ch == '<' || ch == '>' || ch == '|') {
-                        State = Redirect_State;
-                        token[j] = '\0';
-                        save_string(token, &tlist, false);
-                        token[0] = ch;
-                        j = 1;
-                    } else if (ch == ' ') {
-                        State = Blank_State;
-                        token[j] = '\0';
-                        save_string(token, &tlist, false);
-                        j = 0;
-                    } else if (32 <= ch && ch <= 127) {
-                        State = Letter_State;
-                        token[j] = ch;
-                        j++;
-                    } else if (ch == '\n') {
-                        token[j] = '\0';
-                        save_string(token, &tlist, false);
-                    } else {
-                        fprintf(stderr, "Unrecognized character %c\n", ch);
-                        free_tok_list(tlist);;
-                        return;
-                    }
-                } else if (ch == '\n') {
-                    fprintf(stderr, "Quote never closed \"\n");
-                    free_tok_list(tlist);;
-                    return;
-                } else if (ch == '\\') { // handle escaped characters
-                    i++;
-                    char ec = input[i];
-                    if (ec == 'n') {
-                        token[j++] = '\n';
-                    } else if (ec == 'b') {
-                        token[j++] = '\b';
-                    } else if (ec == 'r') {
-                        token[j++] = '\r';
-                    } else if (ec == 't') {
-                        token[j++] = '\t';
-                    } else if (ec == 'v') {
-                        token[j++] = '\v';
-                    } else if (ec == '0') {
-                        token[j++] = '\0';
-                    } else {
-                        token[j++] = input[i-1];
-                        token[j++] = ec;
-                    }
+            case A_Escape:
+                /* known escapes become the real character, anything
+                 * else keeps its backslash */
+                if (escape_char(ch) || ch == '0') {
+                    token[j++] = escape_char(ch);
+                } else if (ch == '$') {
+                    token[j++] = ch;
                 } else {
-                    token[j] = ch;
-                    j++;
+                    add_literal(tlist, j);
+                    token[j++] = '\\';
+                    if (char_class[(unsigned char)ch] == C_Glob) {
+                        add_literal(tlist, j);
+                    }
+                    token[j++] = ch;
                 }
                 break;
-            default:
+            case A_Unescape:
+                /* the \ is just a letter, redo this byte as a letter */
+                add_literal(tlist, j);
+                token[j++] = '\\';
+                tlist->buf_len = j;
+                tlist->prev = '\\';
+                State = t->next;
+                continue;
+            case A_Op_Unescape:
+                token[j] = '\0';
+                save_string(token, &tlist, true);
+                token[0] = '\\';
+                tlist->buf_len = 1;
+                tlist->prev = '\\';
+                State = t->next;
+                continue;
+            case A_Background:
+                save_word(tlist, j);
+                j = 0;
+                save_string("&", &tlist, true);
+                break;
+            case A_Op_Var:
+                token[j] = '\0';
+                save_string(token, &tlist, true);
+                j = 0;
+                /* fall through */
+            case A_Var_Start:
+                /* the $ goes in as is, var_byte() swaps the value in */
+                tlist->var_at = j;
+                tlist->var_brace = false;
+                token[j++] = ch;
+                break;
+            case A_Glob:
+                tlist->glob = true;
+                token[j++] = ch;
                 break;
+            case A_Literal:
+                add_literal(tlist, j);
+                token[j++] = ch;
+                break;
+            case A_Discard_End:
+                i++;
+                reset_state(tlist);
+                *used = i;
+                return TOK_ERROR;
+            case E_Need_Input:
+                fprintf(stderr, "Need input before redirect or pipe\n");
+                goto bad_line;
+            case E_Unrecognized:
+                fprintf(stderr, "Unrecognized character %c\n", ch);
+                goto bad_line;
+            case E_Redirect_End:
+                fprintf(stderr, "Can't have redirect at end of input\n");
+                goto bad_line;
+            case E_Not_Valid:
+                fprintf(stderr, "%c not valid after >\n", ch);
+                goto bad_line;
+            case E_Not_Last:
+                fprintf(stderr, "& has to end the line\n");
+                goto bad_line;
+        }
+        tlist->buf_len = j;
+        tlist->prev = ch;
+        State = t->next;
+        if (State == Single_Quote_State || State == Double_Quote_State) {
+            tlist->quoted = true; // "" is a word even when it is empty
+        }
+        i++;
+
+        /* skip straight over bytes that can't change the state */
+        if (State == Letter_State || State == Single_Quote_State
+                || State == Double_Quote_State) {
+            int run = scan_plain(input + i, end);
+            if (run > 0) {
+                reserve(tlist, run);
+                memcpy(tlist->buf + tlist->buf_len, input + i, run);
+                tlist->buf_len += run;
+                tlist->prev = input[i + run - 1];
+                i += run;
+            }
         }
+        continue;
+
+bad_line:
+        /* throw the line away, the loop skips to its newline */
+        free_tok_list(tlist);
+        reset_state(tlist);
+        State = Discard_State;
     }
-    return;
+
+    /* chunk ran out in the middle of a line */
+    tlist->state = State;
+    *used = i;
+    return TOK_MORE;
+
+line_done:
+    reset_state(tlist);
+    *used = i;
+    return finish_tokens(tlist) ? TOK_DONE : TOK_ERROR;
 }
 
 /**
- * Inserts a new node at the end of the linked list pointed to by head
- * with the given string token and marks whether it is a special
- * token or not based on spec */
-static void save_string (char *token, struct tok_list **tlist, bool spec)
+ * Call when the input has run out. Finishes a line that didn't end
+ * in a newline, or throws it away if it can't be finished
+ */
+enum TOK_STATUS tokenize_end (struct tok_list *tlist)
 {
-    tok_node *t_node = malloc(sizeof(tok_node)); // make new node
-    int length = strlen(token);
-    if (t_node == NULL) {
-        perror("malloc failed in save_string");
-        exit(-1);
+    int used;
+    enum TOK_STATUS status;
+    switch (tlist->state) {
+        case Init_State:
+            return TOK_DONE; // nothing left over
+        case Single_Quote_State:
+        case Single_Escape_State:
+            fprintf(stderr, "Quote never closed \'\n");
+            break;
+        case Double_Quote_State:
+        case Double_Escape_State:
+        case Quoted_Var_State:
+            fprintf(stderr, "Quote never closed \"\n");
+            break;
+        case Discard_State:
+            break;
+        case Heredoc_State:
+            /* like other shells, what there is of the body is used */
+            fprintf(stderr, "Here-document ended by end of input, wanted %s\n",
+                    tlist->toks[tlist->doc_tok].str);
+            do {
+                end_heredoc(tlist);
+            } while (next_heredoc(tlist, tlist->doc_tok));
+            reset_state(tlist);
+            return finish_tokens(tlist) ? TOK_DONE : TOK_ERROR;
+        default:
+            /* a trailing \ needs one newline to undo and one to end */
+            status = tokenize_chunk(tlist, "\n", 1, &used);
+            if (status == TOK_MORE && tlist->state != Heredoc_State) {
+                status = tokenize_chunk(tlist, "\n", 1, &used);
+            }
+            if (status == TOK_MORE) {
+                return tokenize_end(tlist); // a here-doc with no body
+            }
+            return status;
     }
-    t_node->token = malloc(sizeof(char)*length+1); // make space for token
-    if (t_node->token == NULL) {
-        perror("malloc failed in save_string");
+    free_tok_list(tlist);
+    reset_state(tlist);
+    return TOK_ERROR;
+}
+
+/**
+ * true if the tokenizer is partway through a line
+ */
+bool tokenize_pending (struct tok_list *tlist)
+{
+    return tlist->state != Init_State;
+}
+
+/**
+ * Tokenizes one whole line held in a string
+ */
+void tokenize (struct tok_list *tlist, char *input)
+{
+    int used;
+    if (tokenize_chunk(tlist, input, strlen(input), &used) == TOK_MORE) {
+        tokenize_end(tlist);
+    }
+}
+
+/**
+ * makes sure the token buffer has room for n more bytes. the buffer
+ * only ever grows to the size of the biggest token, not the line
+ */
+static void reserve (struct tok_list *tlist, int n)
+{
+    if (tlist->buf_len + n <= tlist->buf_cap) {
+        return;
+    }
+    int cap = tlist->buf_cap ? tlist->buf_cap : 256;
+    while (cap < tlist->buf_len + n) {
+        cap *= 2;
+    }
+    char *bigger = realloc(tlist->buf, cap);
+    if (bigger == NULL) {
+        perror("realloc failed in reserve()");
         exit(-1);
     }
-    strncpy(t_node->token, token, length+1); // put token in node
-    t_node->token[length] = '\0'; // in case strncpy doesn't null terminate
-    t_node->special = spec; // set if token is special
-    t_node->next = NULL; // set next to NULL, node is going at the end
+    tlist->buf = bigger;
+    tlist->buf_cap = cap;
+}
+
+/**
+ * gets the tokenizer ready for the start of a new line
+ */
+static void reset_state (struct tok_list *tlist)
+{
+    tlist->state = Init_State;
+    tlist->prev = '\0';
+    tlist->buf_len = 0;
+    tlist->doc_line = 0;
+    tlist->quoted = false;
+    tlist->glob = false;
+    tlist->lit_ct = 0;
+}
 
-    if ((*tlist)->head == NULL) { // if head is NULL, new node is head
-        (*tlist)->head = t_node;
-        (*tlist)->tail = t_node;
-    } else { // otherwise insert node at the end
-        (*tlist)->tail->next = t_node;
-        (*tlist)->tail = t_node;
+/**
+ * finds the first here-doc after token from whose body hasn't been
+ * read and gets ready to read it. returns false if there isn't one
+ */
+static bool next_heredoc (struct tok_list *tlist, int from)
+{
+    for (int i = from + 1; i + 1 < tlist->count; i++) {
+        if (tlist->toks[i].kind == TOK_HEREDOC) {
+            tlist->doc_tok = i + 1; // the delimiter always follows
+            tlist->buf_len = 0;
+            tlist->doc_line = 0;
+            return true;
+        }
     }
-    (*tlist)->count++; // another token
-    if (!strcmp(token, "|") && spec) {
-        (*tlist)->pcount++; // an actual pipe
+    return false;
+}
+
+/**
+ * adds a line of input, or as much of it as there is, to the body of
+ * the here-doc being read. sets ended when it was the delimiter line,
+ * which isn't part of the body. returns how many bytes were taken
+ */
+static int heredoc_line (struct tok_list *tlist, const char *input,
+        int length, bool *ended)
+{
+    const char *nl = memchr(input, '\n', length);
+    int n = nl == NULL ? length : nl - input + 1;
+    reserve(tlist, n + 1);
+    memcpy(tlist->buf + tlist->buf_len, input, n);
+    tlist->buf_len += n;
+    *ended = false;
+    if (nl == NULL) {
+        return n; // rest of the line is in the next chunk
+    }
+
+    const char *delim = tlist->toks[tlist->doc_tok].str;
+    int line_len = tlist->buf_len - tlist->doc_line - 1;
+    if (line_len == (int)strlen(delim)
+            && !memcmp(tlist->buf + tlist->doc_line, delim, line_len)) {
+        tlist->buf_len = tlist->doc_line;
+        end_heredoc(tlist);
+        *ended = true;
+    } else {
+        tlist->doc_line = tlist->buf_len;
+    }
+    return n;
+}
+
+/**
+ * the body read so far replaces the here-doc's delimiter, both as a
+ * token and as the redirect's text
+ */
+static void end_heredoc (struct tok_list *tlist)
+{
+    reserve(tlist, 1);
+    tlist->buf[tlist->buf_len] = '\0';
+    char *body = arena_strdup(&tlist->arena, tlist->buf);
+    char *delim = tlist->toks[tlist->doc_tok].str;
+    tlist->toks[tlist->doc_tok].str = body;
+    for (int i = 0; i < tlist->redir_ct; i++) {
+        if (tlist->redirs[i].file == delim) {
+            tlist->redirs[i].file = body;
+        }
     }
+    tlist->buf_len = 0;
+    tlist->doc_line = 0;
+}
+
+/**
+ * takes one byte of a $NAME or ${NAME}. once the name has ended the
+ * $ and name in buf are replaced by the value and state goes back to
+ * what it was before the $. a $ that no name follows stays a $.
+ * returns 1 if the byte was used, 0 if it ended the name and has to
+ * be looked at again, -1 for a bad ${...}. buf needs room for two
+ * more bytes
+ */
+static int var_byte (struct tok_list *tlist, char ch, Token_Sys_State *state)
+{
+    char *buf = tlist->buf;
+    int name_at = tlist->var_at + 1 + tlist->var_brace;
+    if (tlist->buf_len == name_at && ch == '{' && !tlist->var_brace) {
+        buf[tlist->buf_len++] = ch;
+        tlist->var_brace = true;
+        return 1;
+    }
+    if (ch == '_' || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')
+            || (ch >= '0' && ch <= '9' && tlist->buf_len > name_at)) {
+        buf[tlist->buf_len++] = ch;
+        return 1;
+    }
+    if (tlist->var_brace && (ch != '}' || tlist->buf_len == name_at)) {
+        buf[tlist->buf_len] = '\0';
+        fprintf(stderr, "Bad variable %s\n", buf + tlist->var_at);
+        return -1;
+    }
+
+    bool quoted = *state == Quoted_Var_State;
+    *state = quoted ? Double_Quote_State : Letter_State;
+    if (tlist->buf_len == name_at) {
+        return 0; // just a $
+    }
+    buf[tlist->buf_len] = '\0';
+    const char *value = var_get(buf + name_at);
+    tlist->buf_len = tlist->var_at;
+    tlist->expanded = true;
+    if (value != NULL) {
+        int len = strlen(value);
+        reserve(tlist, len);
+        memcpy(tlist->buf + tlist->buf_len, value, len);
+        /* wildcards in a value are patterns unless it was quoted */
+        for (int i = 0; i < len; i++) {
+            char c = value[i];
+            if (char_class[(unsigned char)c] != C_Glob && c != '\\') {
+                continue;
+            } else if (quoted) {
+                add_literal(tlist, tlist->buf_len + i);
+            } else {
+                tlist->glob |= c != '\\';
+            }
+        }
+        tlist->buf_len += len;
+    }
+    return tlist->var_brace; // the } is used up
+}
+
+/**
+ * saves the word built so far. a word that is empty only because the
+ * variables in it were empty or unset isn't an argument at all, but
+ * it still counts as the file of a redirect, where it is an error.
+ * a pattern becomes the files it matches, or stays as it is if there
+ * aren't any. the file of a redirect is never a pattern
+ */
+static void save_word (struct tok_list *tlist, int len)
+{
+    struct token *prev = tlist->count ? &tlist->toks[tlist->count-1] : NULL;
+    bool file = prev != NULL && prev->kind != TOK_WORD
+        && prev->kind != TOK_PIPE;
+    tlist->buf[len] = '\0';
+    bool matched = tlist->glob && !file && glob_word(tlist, len);
+    if (!matched && (len > 0 || tlist->quoted || file)) {
+        save_string(tlist->buf, &tlist, false);
+    }
+    tlist->quoted = false;
+    tlist->glob = false;
+    tlist->lit_ct = 0;
+}
+
+/**
+ * notes that the byte at buf[at] only matches itself if the word
+ * turns out to be a pattern
+ */
+static void add_literal (struct tok_list *tlist, int at)
+{
+    if (tlist->lit_ct == tlist->lit_cap) {
+        tlist->lits = grow(tlist->lits, &tlist->lit_cap, tlist->lit_ct,
+                sizeof(int));
+    }
+    tlist->lits[tlist->lit_ct++] = at;
+}
+
+/**
+ * saves every file the word in buf matches. the quoted wildcards and
+ * backslashes in it get a backslash so they match themselves. returns
+ * false if nothing matched
+ */
+static bool glob_word (struct tok_list *tlist, int len)
+{
+    char *pattern = tlist->buf;
+    if (tlist->lit_ct > 0) {
+        pattern = arena_alloc(&tlist->arena, len + tlist->lit_ct + 1);
+        int p = 0;
+        for (int i = 0, l = 0; i < len; i++) {
+            if (l < tlist->lit_ct && tlist->lits[l] == i) {
+                pattern[p++] = '\\';
+                l++;
+            }
+            pattern[p++] = tlist->buf[i];
+        }
+        pattern[p] = '\0';
+    }
+    tlist->expanded = true; // what matches may be different next time
+    return wildcard_pattern(pattern)
+        && wildcard_expand(pattern, add_match, tlist) > 0;
+}
+
+/**
+ * wildcard_expand() callback saving one match as a word
+ */
+static void add_match (const char *path, void *arg)
+{
+    struct tok_list *tlist = arg;
+    add_token(tlist, arena_strdup(&tlist->arena, path), TOK_WORD);
+}
+
+/**
+ * fills in the character class table the first time it's needed
+ */
+static void init_classes ()
+{
+    static bool ready = false;
+    if (ready) {
+        return;
+    }
+    for (int c = 32; c <= 127; c++) {
+        char_class[c] = C_Print;
+    }
+    char_class['\n'] = C_Newline;
+    char_class[' '] = C_Space;
+    char_class['"'] = C_Dquote;
+    char_class['\''] = C_Squote;
+    char_class['\\'] = C_Backslash;
+    char_class['<'] = C_Less;
+    char_class['>'] = C_Greater;
+    char_class['|'] = C_Pipe;
+    char_class['&'] = C_Amp;
+    char_class['$'] = C_Dollar;
+    char_class['*'] = C_Glob;
+    char_class['?'] = C_Glob;
+    char_class['['] = C_Glob;
+    ready = true;
+}
+
+/**
+ * returns how many bytes from p on are plain C_Print bytes that no
+ * state cares about. stops at a blank, control byte, byte above 127,
+ * quote, backslash, <, >, |, &, $ or wildcard. uses AVX2 or SSE2 when
+ * built for them
+ */
+static size_t scan_plain (const char *p, const char *end)
+{
+    const char *start = p;
+#if defined(__AVX2__)
+    const __m256i limit = _mm256_set1_epi8(33);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        /* signed compare, so bytes above 127 count as below 33 */
+        __m256i stop = _mm256_cmpgt_epi8(limit, v);
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '"'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '\''));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '\\'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '<'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '>'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '|'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '&'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '$'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '*'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '?'));
+        stop = _mm256_or_si256(stop, AVX_EQ(v, '['));
+        unsigned int mask = _mm256_movemask_epi8(stop);
+        if (mask) {
+            return p - start + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i limit16 = _mm_set1_epi8(33);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i stop = _mm_cmplt_epi8(v, limit16);
+        stop = _mm_or_si128(stop, SSE_EQ(v, '"'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '\''));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '\\'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '<'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '>'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '|'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '&'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '$'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '*'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '?'));
+        stop = _mm_or_si128(stop, SSE_EQ(v, '['));
+        unsigned int mask = _mm_movemask_epi8(stop);
+        if (mask) {
+            return p - start + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && char_class[(unsigned char)*p] == C_Print) {
+        p++;
+    }
+    return p - start;
+}
+
+/**
+ * the character a known escape stands for, 0 for unknown escapes
+ * (and for \0, which really is 0)
+ */
+static char escape_char (char ec)
+{
+    switch (ec) {
+        case 'n': return '\n';
+        case 'b': return '\b';
+        case 'r': return '\r';
+        case 't': return '\t';
+        case 'v': return '\v';
+        default:  return '\0';
+    }
+}
+
+/**
+ * Copies the given string token into the list's arena and appends it
+ * to the token array, marking whether it is a special token or not
+ * based on spec */
+static void save_string (char *token, struct tok_list **tlist, bool spec)
+{
+    char *str = arena_strdup(&(*tlist)->arena, token);
+    add_token(*tlist, str, spec ? op_kind(token) : TOK_WORD);
     return;
 }
 
 /**
- * call to free all nodes
+ * Appends a token without copying it, str has to stay valid until
+ * the list is freed. Words are also sorted into the current command's
+ * argv or redirects here so the executor never has to look at the
+ * tokens again */
+void add_token (struct tok_list *tl, char *str, enum TOK_KIND kind)
+{
+    if (tl->count == tl->tok_cap) {
+        tl->toks = grow(tl->toks, &tl->tok_cap, tl->count,
+                sizeof(struct token));
+    }
+    struct token *tok = &tl->toks[tl->count++]; // another token
+    tok->str = str;
+    tok->kind = kind;
+
+    if (tl->cmd_ct == 0) { // first token starts the first command
+        new_command(tl);
+    }
+
+    if (tok->kind == TOK_PIPE) {
+        tl->pcount++; // an actual pipe
+        end_command(tl);
+        new_command(tl);
+    } else if (tok->kind == TOK_BG) {
+        tl->background = true;
+    } else if (tok->kind == TOK_WORD) {
+        struct token *prev = tl->count > 1 ? tok - 1 : NULL;
+        if (prev != NULL && prev->kind != TOK_WORD && prev->kind != TOK_PIPE) {
+            /* word right after a redirect is the file to redirect to */
+            if (tl->redir_ct == tl->redir_cap) {
+                tl->redirs = grow(tl->redirs, &tl->redir_cap, tl->redir_ct,
+                        sizeof(struct redirect));
+            }
+            tl->redirs[tl->redir_ct].kind = prev->kind;
+            tl->redirs[tl->redir_ct].file = tok->str;
+            tl->redir_ct++;
+            tl->cmds[tl->cmd_ct-1].redir_ct++;
+        } else {
+            push_arg(tl, tok->str);
+            tl->cmds[tl->cmd_ct-1].argc++;
+        }
+    }
+}
+
+/**
+ * which kind of special token an operator string is
+ */
+static enum TOK_KIND op_kind (char *op)
+{
+    if (op[0] == '|') {
+        return TOK_PIPE;
+    } else if (op[0] == '&') {
+        return TOK_BG;
+    } else if (op[0] == '<') {
+        if (op[1] != '<') {
+            return TOK_IN;
+        }
+        return op[2] == '<' ? TOK_HERESTR : TOK_HEREDOC;
+    } else if (op[1] == '>') {
+        return TOK_APPEND;
+    }
+    return TOK_OUT;
+}
+
+/**
+ * starts a command whose words and redirects begin at the current
+ * ends of the argv and redirect arrays
+ */
+static void new_command (struct tok_list *tlist)
+{
+    if (tlist->cmd_ct == tlist->cmd_cap) {
+        tlist->cmds = grow(tlist->cmds, &tlist->cmd_cap, tlist->cmd_ct,
+                sizeof(struct command));
+    }
+    struct command *cmd = &tlist->cmds[tlist->cmd_ct++];
+    cmd->argv = NULL;
+    cmd->argc = 0;
+    cmd->redirs = NULL;
+    cmd->redir_ct = 0;
+    cmd->first_arg = tlist->argv_ct;
+    cmd->first_redir = tlist->redir_ct;
+}
+
+/**
+ * NULL terminates the current command's argv in place
+ */
+static void end_command (struct tok_list *tlist)
+{
+    push_arg(tlist, NULL);
+}
+
+/**
+ * called once a line has been tokenized. the arrays can't move any
+ * more, so each command gets pointers to its slices. a command left
+ * with no words, because its only words were empty variables, throws
+ * the line away and returns false
+ */
+bool finish_tokens (struct tok_list *tlist)
+{
+    if (tlist->cmd_ct == 0) {
+        return true;
+    }
+    end_command(tlist);
+    for (int i = 0; i < tlist->cmd_ct; i++) {
+        struct command *cmd = &tlist->cmds[i];
+        if (cmd->argc == 0) {
+            fprintf(stderr, "Empty command\n");
+            free_tok_list(tlist);
+            return false;
+        }
+        cmd->argv = tlist->argv + cmd->first_arg;
+        cmd->redirs = tlist->redirs + cmd->first_redir;
+    }
+    return true;
+}
+
+/**
+ * appends to the argv array
+ */
+static void push_arg (struct tok_list *tlist, char *arg)
+{
+    if (tlist->argv_ct == tlist->argv_cap) {
+        tlist->argv = grow(tlist->argv, &tlist->argv_cap, tlist->argv_ct,
+                sizeof(char *));
+    }
+    tlist->argv[tlist->argv_ct++] = arg;
+}
+
+/**
+ * doubles the capacity of one of the list's arrays. the arrays are
+ * kept between lines so this only happens when a line is bigger than
+ * any line before it
+ */
+static void *grow (void *arr, int *cap, int count, size_t size)
+{
+    int new_cap = *cap ? *cap * 2 : 16;
+    void *bigger = realloc(arr, new_cap * size);
+    if (bigger == NULL) {
+        perror("realloc failed in grow()");
+        exit(-1);
+    }
+    *cap = new_cap;
+    return bigger;
+}
+
+/**
+ * sets up an empty list
+ */
+void init_tok_list (struct tok_list *tlist)
+{
+    memset(tlist, 0, sizeof(struct tok_list));
+    arena_init(&tlist->arena, ARENA_RETAIN);
+}
+
+/**
+ * call to empty the list. the memory is kept for the next line
  */
 void free_tok_list (struct tok_list *tlist)
 {
-    tok_node *temp = tlist->head;
-    while (temp != NULL) {
-        tlist->head = tlist->head->next;
-        free(temp->token);
-        free(temp);
-        temp = tlist->head;
-    }
-    tlist->head = NULL;
-    tlist->tail = NULL;
     tlist->count = 0;
+    tlist->argv_ct = 0;
+    tlist->redir_ct = 0;
+    tlist->cmd_ct = 0;
     tlist->pcount = 0;
+    tlist->background = false;
+    tlist->expanded = false;
+    arena_reset(&tlist->arena);
     return;
 }
 
+/**
+ * call when the list won't be used again to give back its memory
+ */
+void destroy_tok_list (struct tok_list *tlist)
+{
+    free_tok_list(tlist);
+    free(tlist->toks);
+    free(tlist->argv);
+    free(tlist->redirs);
+    free(tlist->cmds);
+    free(tlist->buf);
+    free(tlist->lits);
+    arena_free(&tlist->arena);
+    init_tok_list(tlist);
+}
+
 /**
  * prints all the tokens in the list and whether
  * they are special or not
  */
-void print_tokens (tok_node *head)
+void print_tokens (struct tok_list *tlist)
 {
-    tok_node *list = head;
-    while (list != NULL) {
-        printf("%d:%s\n", list->special, list->token);
-        list = list->next;
+    for (int i = 0; i < tlist->count; i++) {
+        printf("%d:%s\n", tlist->toks[i].kind != TOK_WORD, tlist->toks[i].str);
     }
 }
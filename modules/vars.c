@@ -0,0 +1,336 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                   vars.c                     *
+ ************************************************
+ * The shell's variables, in a hash table that  *
+ * starts out as a copy of the environment.     *
+ * Exported variables are passed to commands in *
+ * an envp array that is only put back together *
+ * after one of them has changed                *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#include "../includes/vars.h"
+#include "../includes/hashtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern char **environ;
+
+struct var {
+    char *entry;        // NAME=value, the way envp wants it
+    size_t name_len;
+    bool exported;
+};
+
+static struct hash_table var_table;
+static bool loaded = false;
+static unsigned long generation = 0; // bumped by every change
+static char **envp = NULL;
+static int envp_cap = 0;
+static bool envp_stale = true;
+static char **retired = NULL; // old entries envp may still point at
+static int retired_ct = 0;
+static int retired_cap = 0;
+
+static void load ();
+static struct var *new_var (const char *, size_t, const char *);
+static void drop_entry (struct var *);
+static void collect_exported (hash_node *, void *);
+static void collect_all (hash_node *, void *);
+static int by_name (const void *, const void *);
+
+/**
+ * the value of a variable, NULL if it isn't set
+ */
+const char *var_get (const char *name)
+{
+    load();
+    struct var *v = ht_get(&var_table, name);
+    return v ? v->entry + v->name_len + 1 : NULL;
+}
+
+/**
+ * sets a variable, exporting it if export is true. a variable that
+ * was already exported stays that way. returns false for a bad name
+ */
+bool var_set (const char *name, const char *value, bool export)
+{
+    size_t name_len = strlen(name);
+    if (!var_name_ok(name, name_len)) {
+        return false;
+    }
+    load();
+    struct var *v = ht_get(&var_table, name);
+    if (v == NULL) {
+        v = new_var(name, name_len, value);
+        ht_put(&var_table, name, v);
+    } else {
+        drop_entry(v);
+        struct var *fresh = new_var(name, name_len, value);
+        v->entry = fresh->entry;
+        free(fresh);
+    }
+    if (export) {
+        v->exported = true;
+    }
+    if (v->exported) {
+        envp_stale = true;
+    }
+    generation++;
+    return true;
+}
+
+/**
+ * exports a variable that is already set. returns false if it isn't
+ */
+bool var_export (const char *name)
+{
+    load();
+    struct var *v = ht_get(&var_table, name);
+    if (v == NULL) {
+        return false;
+    }
+    if (!v->exported) {
+        v->exported = true;
+        envp_stale = true;
+        generation++;
+    }
+    return true;
+}
+
+/**
+ * forgets a variable, if it was set
+ */
+void var_unset (const char *name)
+{
+    load();
+    struct var *v = ht_remove(&var_table, name);
+    if (v == NULL) {
+        return;
+    }
+    drop_entry(v);
+    free(v);
+    generation++;
+}
+
+/**
+ * if word is NAME=value, sets NAME without exporting it and returns
+ * true. false if it is any other word
+ */
+bool var_assign (const char *word)
+{
+    const char *eq = strchr(word, '=');
+    if (eq == NULL || !var_name_ok(word, eq - word)) {
+        return false;
+    }
+    char name[eq - word + 1];
+    memcpy(name, word, eq - word);
+    name[eq - word] = '\0';
+    return var_set(name, eq + 1, false);
+}
+
+/**
+ * true if the len bytes at name are letters, digits and underscores
+ * and don't start with a digit
+ */
+bool var_name_ok (const char *name, size_t len)
+{
+    if (len == 0 || (name[0] >= '0' && name[0] <= '9')) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                || (c >= '0' && c <= '9'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * goes up every time any variable changes, so a caller that keeps
+ * something made from a variable can tell when it has to redo it
+ */
+unsigned long var_generation ()
+{
+    return generation;
+}
+
+/**
+ * the exported variables as an envp array for posix_spawn and execve.
+ * it is only put back together after an exported variable changed,
+ * otherwise the same array is handed back. environ points at it too,
+ * so anything in libc that reads the environment sees the same thing
+ */
+char **var_environ ()
+{
+    load();
+    if (!envp_stale) {
+        return envp;
+    }
+    if (var_table.count + 1 > envp_cap) {
+        int cap = envp_cap ? envp_cap : 64;
+        while (cap < var_table.count + 1) {
+            cap *= 2;
+        }
+        char **bigger = realloc(envp, cap * sizeof(char *));
+        if (bigger == NULL) {
+            perror("realloc failed in var_environ()");
+            exit(-1);
+        }
+        envp = bigger;
+        envp_cap = cap;
+    }
+    char **next = envp;
+    ht_foreach(&var_table, collect_exported, &next);
+    *next = NULL;
+    environ = envp;
+    envp_stale = false;
+
+    /* nothing points at the old entries any more */
+    for (int i = 0; i < retired_ct; i++) {
+        free(retired[i]);
+    }
+    retired_ct = 0;
+    return envp;
+}
+
+/**
+ * prints the variables sorted by name, the exported ones as export
+ * commands, or every one as NAME=value
+ */
+void var_print (bool exported_only)
+{
+    load();
+    struct var **all = malloc((var_table.count + 1) * sizeof(struct var *));
+    if (all == NULL) {
+        perror("malloc failed in var_print()");
+        return;
+    }
+    struct var **next = all;
+    ht_foreach(&var_table, collect_all, &next);
+    int ct = next - all;
+    qsort(all, ct, sizeof(struct var *), by_name);
+    for (int i = 0; i < ct; i++) {
+        if (!exported_only) {
+            printf("%s\n", all[i]->entry);
+        } else if (all[i]->exported) {
+            printf("export %s\n", all[i]->entry);
+        }
+    }
+    free(all);
+}
+
+/**
+ * copies the environment the shell was started with into the table
+ * the first time any variable is wanted
+ */
+static void load ()
+{
+    if (loaded) {
+        return;
+    }
+    loaded = true;
+    ht_init(&var_table, 128);
+    for (char **env = environ; *env != NULL; env++) {
+        const char *eq = strchr(*env, '=');
+        if (eq == NULL) {
+            continue;
+        }
+        char name[eq - *env + 1];
+        memcpy(name, *env, eq - *env);
+        name[eq - *env] = '\0';
+        if (ht_get(&var_table, name) != NULL) {
+            continue; // getenv() would have found the first one
+        }
+        struct var *v = new_var(name, eq - *env, eq + 1);
+        v->exported = true;
+        ht_put(&var_table, name, v);
+    }
+}
+
+/**
+ * makes a variable holding NAME=value, not exported
+ */
+static struct var *new_var (const char *name, size_t name_len,
+        const char *value)
+{
+    size_t value_len = strlen(value);
+    struct var *v = malloc(sizeof(struct var));
+    char *entry = malloc(name_len + value_len + 2);
+    if (v == NULL || entry == NULL) {
+        perror("malloc failed in new_var()");
+        exit(-1);
+    }
+    memcpy(entry, name, name_len);
+    entry[name_len] = '=';
+    memcpy(entry + name_len + 1, value, value_len + 1);
+    v->entry = entry;
+    v->name_len = name_len;
+    v->exported = false;
+    return v;
+}
+
+/**
+ * lets go of a variable's NAME=value. envp may still point at an
+ * exported one, so it is kept until envp has been put back together
+ */
+static void drop_entry (struct var *v)
+{
+    if (!v->exported) {
+        free(v->entry);
+        return;
+    }
+    if (retired_ct == retired_cap) {
+        retired_cap = retired_cap ? retired_cap * 2 : 16;
+        retired = realloc(retired, retired_cap * sizeof(char *));
+        if (retired == NULL) {
+            perror("realloc failed in drop_entry()");
+            exit(-1);
+        }
+    }
+    retired[retired_ct++] = v->entry;
+    envp_stale = true;
+}
+
+/**
+ * ht_foreach() callback adding exported entries to an envp array
+ */
+static void collect_exported (hash_node *node, void *arg)
+{
+    char ***next = arg;
+    struct var *v = node->value;
+    if (v->exported) {
+        *(*next)++ = v->entry;
+    }
+}
+
+/**
+ * ht_foreach() callback adding every variable to an array
+ */
+static void collect_all (hash_node *node, void *arg)
+{
+    struct var ***next = arg;
+    *(*next)++ = node->value;
+}
+
+/**
+ * qsort() order of variables by name
+ */
+static int by_name (const void *a, const void *b)
+{
+    const struct var *va = *(struct var * const *)a;
+    const struct var *vb = *(struct var * const *)b;
+    size_t len = va->name_len < vb->name_len ? va->name_len : vb->name_len;
+    int diff = memcmp(va->entry, vb->entry, len);
+    if (diff != 0) {
+        return diff;
+    }
+    return va->name_len < vb->name_len ? -1 : va->name_len > vb->name_len;
+}
@@ -0,0 +1,620 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 wildcard.c                   *
+ ************************************************
+ * Expands words with *, ? and [...] into the   *
+ * file names they match. Directories are read  *
+ * with big getdents64 batches, and a ** is     *
+ * walked by a pool of threads that steal       *
+ * directories from each other                  *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include "../includes/wildcard.h"
+#include "../includes/arena.h"
+#include "../includes/options.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fnmatch.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define DENTS_BUF (256*1024) // bytes asked for by each getdents64()
+
+/* what getdents64() fills its buffer with */
+struct linux_dirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/* one piece of the pattern between slashes. the common shapes are
+ * matched without fnmatch() */
+enum SEG_KIND {
+    SEG_LITERAL,    // no wildcards, the dir doesn't have to be read
+    SEG_STAR,       // text*suffix, either side may be empty
+    SEG_MATCH,      // anything else, up to fnmatch()
+    SEG_RECURSE     // **, any number of dirs
+};
+
+struct segment {
+    enum SEG_KIND kind;
+    char *text;
+    size_t len;
+    char *suffix;   // after the * of a SEG_STAR
+    size_t suffix_len;
+};
+
+/* a dir still to be read. prefix is what goes in front of the names
+ * in it, "" for the current dir, otherwise ending in a / */
+struct item {
+    const char *prefix;
+    int len;
+    int seg;        // the segment its names are matched against
+};
+
+struct walk;
+
+struct worker {
+    struct walk *walk;
+    int id;
+    pthread_mutex_t lock;
+    struct item *items; // owner takes from the back, thieves the front
+    int head;
+    int tail;
+    int cap;
+    struct arena arena; // prefixes and found paths
+    char **found;
+    long found_ct;
+    long found_cap;
+    char *dents;
+    pthread_t thread;
+};
+
+struct walk {
+    struct segment *segs;
+    int seg_ct;
+    bool want_dir;      // pattern ended in /
+    struct worker *workers;
+    int worker_ct;
+    atomic_long pending; // items queued or being read
+};
+
+static bool has_meta (const char *, size_t);
+static char *parse (const char *, struct walk *);
+static void classify (struct segment *);
+static int worker_count (struct walk *);
+static void *work (void *);
+static void walk_item (struct worker *, const char *, int, int);
+static void read_dir (struct worker *, const char *, int, int);
+static void match_entry (struct worker *, int, const char *, int,
+        struct linux_dirent64 *, int);
+static bool seg_match (struct segment *, const char *);
+static bool is_dir (int, struct linux_dirent64 *, bool);
+static char *make_path (struct worker *, const char *, int, const char *,
+        size_t, bool);
+static void add_found (struct worker *, char *);
+static void enter_dir (struct worker *, char *, int);
+static void push (struct worker *, const char *, int, int);
+static bool pop (struct worker *, struct item *);
+static bool steal (struct worker *, struct item *);
+static int by_path (const void *, const void *);
+
+/**
+ * true if word has a *, a ? or a [ that is closed by a ], not
+ * counting ones escaped with a backslash
+ */
+bool wildcard_pattern (const char *word)
+{
+    return has_meta(word, strlen(word));
+}
+
+/**
+ * calls found with every path that matches pattern, sorted and each
+ * one once. names starting with . are only matched by a pattern that
+ * starts with a . too. returns how many there were
+ */
+int wildcard_expand (const char *pattern,
+        void (*found)(const char *, void *), void *arg)
+{
+    static char *main_dents = NULL; // kept, the calling thread globs a lot
+    struct walk walk;
+    char *text = parse(pattern, &walk);
+    if (walk.seg_ct == 0) {
+        free(text);
+        free(walk.segs);
+        return 0;
+    }
+
+    walk.worker_ct = worker_count(&walk);
+    walk.workers = calloc(walk.worker_ct, sizeof(struct worker));
+    if (main_dents == NULL) {
+        main_dents = malloc(DENTS_BUF);
+    }
+    if (walk.workers == NULL || main_dents == NULL) {
+        perror("malloc failed in wildcard_expand()");
+        exit(-1);
+    }
+    atomic_init(&walk.pending, 0);
+    for (int i = 0; i < walk.worker_ct; i++) {
+        struct worker *w = &walk.workers[i];
+        w->walk = &walk;
+        w->id = i;
+        pthread_mutex_init(&w->lock, NULL);
+        arena_init(&w->arena, 0);
+        w->dents = i == 0 ? main_dents : malloc(DENTS_BUF);
+        if (w->dents == NULL) {
+            perror("malloc failed in wildcard_expand()");
+            exit(-1);
+        }
+    }
+
+    push(&walk.workers[0], pattern[0] == '/' ? "/" : "", pattern[0] == '/', 0);
+    for (int i = 1; i < walk.worker_ct; i++) {
+        if (pthread_create(&walk.workers[i].thread, NULL, work,
+                    &walk.workers[i])) {
+            walk.workers[i].thread = 0; // the others do its share
+        }
+    }
+    work(&walk.workers[0]);
+    for (int i = 1; i < walk.worker_ct; i++) {
+        if (walk.workers[i].thread) {
+            pthread_join(walk.workers[i].thread, NULL);
+        }
+    }
+
+    /* every thread's paths go in one array of pointers to be sorted,
+     * the paths themselves stay where they are in the arenas */
+    long total = 0;
+    for (int i = 0; i < walk.worker_ct; i++) {
+        total += walk.workers[i].found_ct;
+    }
+    char **all = malloc((total + 1) * sizeof(char *));
+    if (all == NULL) {
+        perror("malloc failed in wildcard_expand()");
+        exit(-1);
+    }
+    long n = 0;
+    for (int i = 0; i < walk.worker_ct; i++) {
+        struct worker *w = &walk.workers[i];
+        memcpy(all + n, w->found, w->found_ct * sizeof(char *));
+        n += w->found_ct;
+    }
+    qsort(all, total, sizeof(char *), by_path);
+    int count = 0;
+    for (long i = 0; i < total; i++) {
+        /* a path can be reached twice when there is more than one ** */
+        if (i == 0 || strcmp(all[i], all[i-1])) {
+            found(all[i], arg);
+            count++;
+        }
+    }
+
+    free(all);
+    for (int i = 0; i < walk.worker_ct; i++) {
+        struct worker *w = &walk.workers[i];
+        pthread_mutex_destroy(&w->lock);
+        arena_free(&w->arena);
+        free(w->items);
+        free(w->found);
+        if (i > 0) {
+            free(w->dents);
+        }
+    }
+    free(walk.workers);
+    free(walk.segs);
+    free(text);
+    return count;
+}
+
+/**
+ * has_meta() for the len bytes at s
+ */
+static bool has_meta (const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '\\') {
+            i++;
+        } else if (s[i] == '*' || s[i] == '?') {
+            return true;
+        } else if (s[i] == '[' && i + 2 < len
+                && memchr(s + i + 2, ']', len - i - 2) != NULL) {
+            return true; // the first byte after [ can be a ]
+        }
+    }
+    return false;
+}
+
+/**
+ * splits a copy of pattern into segments at its slashes. empty ones
+ * are dropped and a run of ** is kept as one. returns the copy, which
+ * the segments point into
+ */
+static char *parse (const char *pattern, struct walk *walk)
+{
+    char *text = strdup(pattern);
+    int max = 1;
+    for (const char *c = pattern; *c; c++) {
+        max += *c == '/';
+    }
+    walk->segs = malloc(max * sizeof(struct segment));
+    if (text == NULL || walk->segs == NULL) {
+        perror("malloc failed in parse()");
+        exit(-1);
+    }
+    walk->seg_ct = 0;
+    size_t length = strlen(text);
+    walk->want_dir = length > 0 && text[length-1] == '/';
+
+    char *save;
+    for (char *piece = strtok_r(text, "/", &save); piece != NULL;
+            piece = strtok_r(NULL, "/", &save)) {
+        struct segment *seg = &walk->segs[walk->seg_ct];
+        seg->text = piece;
+        seg->len = strlen(piece);
+        classify(seg);
+        if (seg->kind == SEG_RECURSE && walk->seg_ct > 0
+                && seg[-1].kind == SEG_RECURSE) {
+            continue;
+        }
+        walk->seg_ct++;
+    }
+    return text;
+}
+
+/**
+ * works out which kind a segment is. literal ones lose their
+ * backslashes since they are compared as they are
+ */
+static void classify (struct segment *seg)
+{
+    char *s = seg->text;
+    size_t len = seg->len;
+    if (!has_meta(s, len)) {
+        size_t j = 0;
+        for (size_t i = 0; i < len; i++) {
+            if (s[i] == '\\' && i + 1 < len) {
+                i++;
+            }
+            s[j++] = s[i];
+        }
+        s[j] = '\0';
+        seg->len = j;
+        seg->kind = SEG_LITERAL;
+    } else if (!strcmp(s, "**")) {
+        seg->kind = SEG_RECURSE;
+    } else if (strpbrk(s, "?[\\") == NULL
+            && strchr(s, '*') == strrchr(s, '*')) {
+        char *star = strchr(s, '*');
+        seg->kind = SEG_STAR;
+        seg->len = star - s;
+        seg->suffix = star + 1;
+        seg->suffix_len = len - seg->len - 1;
+    } else {
+        seg->kind = SEG_MATCH;
+    }
+}
+
+/**
+ * one thread is enough unless there is a ** to walk. then it is
+ * setopt globthreads, or one per CPU
+ */
+static int worker_count (struct walk *walk)
+{
+    bool recurse = false;
+    for (int i = 0; i < walk->seg_ct; i++) {
+        recurse |= walk->segs[i].kind == SEG_RECURSE;
+    }
+    if (!recurse) {
+        return 1;
+    }
+    long n = get_option(OPT_GLOBTHREADS);
+    if (n == 0) {
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (n < 1) {
+        n = 1;
+    } else if (n > WILDCARD_MAX_WORKERS) {
+        n = WILDCARD_MAX_WORKERS;
+    }
+    return n;
+}
+
+/**
+ * reads dirs off the worker's own queue, newest first, and steals
+ * the oldest from the others when it runs dry. stops once no dir is
+ * queued or being read anywhere
+ */
+static void *work (void *arg)
+{
+    struct worker *w = arg;
+    struct item it;
+    while (atomic_load(&w->walk->pending) > 0) {
+        if (pop(w, &it) || steal(w, &it)) {
+            walk_item(w, it.prefix, it.len, it.seg);
+            atomic_fetch_sub(&w->walk->pending, 1);
+        } else {
+            sched_yield(); // someone is still reading a dir
+        }
+    }
+    return NULL;
+}
+
+/**
+ * matches the names under prefix against segment seg on. literal
+ * segments are just added to the prefix without reading anything
+ */
+static void walk_item (struct worker *w, const char *prefix, int len, int seg)
+{
+    struct walk *walk = w->walk;
+    while (walk->segs[seg].kind == SEG_LITERAL) {
+        struct segment *s = &walk->segs[seg];
+        if (seg + 1 == walk->seg_ct) {
+            char *path = make_path(w, prefix, len, s->text, s->len,
+                    walk->want_dir);
+            struct stat st;
+            if (fstatat(AT_FDCWD, path, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                add_found(w, path);
+            }
+            return;
+        }
+        char *dir = make_path(w, prefix, len, s->text, s->len, true);
+        enter_dir(w, dir, seg + 1);
+        prefix = dir;
+        len += s->len + 1;
+        seg++;
+    }
+    read_dir(w, prefix, len, seg);
+}
+
+/**
+ * reads a whole dir a big batch at a time. for a ** every dir in it
+ * is queued to be read the same way, and every name is also matched
+ * against what comes after the **, as if it matched no dirs
+ */
+static void read_dir (struct worker *w, const char *prefix, int len, int seg)
+{
+    struct walk *walk = w->walk;
+    bool recurse = walk->segs[seg].kind == SEG_RECURSE;
+    int fd = open(len ? prefix : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return; // gone, not a dir, or can't be read
+    }
+    long n;
+    while ((n = syscall(SYS_getdents64, fd, w->dents, DENTS_BUF)) > 0) {
+        for (long off = 0; off < n;) {
+            struct linux_dirent64 *d =
+                (struct linux_dirent64 *)(w->dents + off);
+            off += d->d_reclen;
+            const char *name = d->d_name;
+            if (name[0] == '.' && (name[1] == '\0'
+                        || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            if (!recurse) {
+                match_entry(w, fd, prefix, len, d, seg);
+                continue;
+            }
+            /* ** doesn't go into hidden dirs or match hidden names
+             * itself, the segment after it still can */
+            bool hidden = name[0] == '.';
+            if (!hidden && is_dir(fd, d, false)) { // nor follow links
+                size_t name_len = strlen(name);
+                push(w, make_path(w, prefix, len, name, name_len, true),
+                        len + name_len + 1, seg);
+            }
+            if (seg + 1 == walk->seg_ct) {
+                /* a ** at the end matches everything under it */
+                if (!hidden && (!walk->want_dir || is_dir(fd, d, true))) {
+                    add_found(w, make_path(w, prefix, len, name,
+                                strlen(name), walk->want_dir));
+                }
+            } else {
+                match_entry(w, fd, prefix, len, d, seg + 1);
+            }
+        }
+    }
+    close(fd);
+}
+
+/**
+ * if the entry matches segment seg it is a result when that is the
+ * last segment, otherwise a dir to look in next
+ */
+static void match_entry (struct worker *w, int fd, const char *prefix, int len,
+        struct linux_dirent64 *d, int seg)
+{
+    struct walk *walk = w->walk;
+    if (!seg_match(&walk->segs[seg], d->d_name)) {
+        return;
+    }
+    size_t name_len = strlen(d->d_name);
+    if (seg + 1 == walk->seg_ct) {
+        /* no stat unless only dirs are wanted */
+        if (!walk->want_dir || is_dir(fd, d, true)) {
+            add_found(w, make_path(w, prefix, len, d->d_name, name_len,
+                        walk->want_dir));
+        }
+    } else if (is_dir(fd, d, true)) {
+        char *dir = make_path(w, prefix, len, d->d_name, name_len, true);
+        enter_dir(w, dir, seg + 1);
+        push(w, dir, len + name_len + 1, seg + 1);
+    }
+}
+
+/**
+ * a ** at the end matches the dir it starts in too, as in bash. the
+ * dirs under it are found as names by read_dir()
+ */
+static void enter_dir (struct worker *w, char *dir, int seg)
+{
+    struct walk *walk = w->walk;
+    if (seg + 1 == walk->seg_ct && walk->segs[seg].kind == SEG_RECURSE) {
+        add_found(w, dir);
+    }
+}
+
+/**
+ * true if name matches a segment. wildcards don't match a leading .
+ */
+static bool seg_match (struct segment *seg, const char *name)
+{
+    size_t len;
+    switch (seg->kind) {
+        case SEG_LITERAL:
+            return !strcmp(name, seg->text);
+        case SEG_STAR:
+            if (seg->len == 0 && name[0] == '.') {
+                return false;
+            }
+            len = strlen(name);
+            return len >= seg->len + seg->suffix_len
+                && !memcmp(name, seg->text, seg->len)
+                && !memcmp(name + len - seg->suffix_len, seg->suffix,
+                        seg->suffix_len);
+        case SEG_MATCH:
+        case SEG_RECURSE:
+            break;
+    }
+    return !fnmatch(seg->text, name, FNM_PERIOD);
+}
+
+/**
+ * whether an entry is a dir. d_type is trusted, the entry is only
+ * stat'd when the file system doesn't fill it in, or for a link if
+ * links are to be followed
+ */
+static bool is_dir (int fd, struct linux_dirent64 *d, bool follow)
+{
+    if (d->d_type == DT_DIR) {
+        return true;
+    }
+    if (d->d_type != DT_UNKNOWN && !(d->d_type == DT_LNK && follow)) {
+        return false;
+    }
+    struct stat st;
+    if (fstatat(fd, d->d_name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) < 0) {
+        return false;
+    }
+    return S_ISDIR(st.st_mode);
+}
+
+/**
+ * prefix and name put together in the worker's arena, with a /
+ * after them if slash is true
+ */
+static char *make_path (struct worker *w, const char *prefix, int len,
+        const char *name, size_t name_len, bool slash)
+{
+    char *path = arena_alloc(&w->arena, len + name_len + 2);
+    memcpy(path, prefix, len);
+    memcpy(path + len, name, name_len);
+    path[len + name_len] = '/';
+    path[len + name_len + slash] = '\0';
+    return path;
+}
+
+/**
+ * keeps a matching path
+ */
+static void add_found (struct worker *w, char *path)
+{
+    if (w->found_ct == w->found_cap) {
+        w->found_cap = w->found_cap ? w->found_cap * 2 : 64;
+        w->found = realloc(w->found, w->found_cap * sizeof(char *));
+        if (w->found == NULL) {
+            perror("realloc failed in add_found()");
+            exit(-1);
+        }
+    }
+    w->found[w->found_ct++] = path;
+}
+
+/**
+ * queues a dir on the worker's own queue
+ */
+static void push (struct worker *w, const char *prefix, int len, int seg)
+{
+    atomic_fetch_add(&w->walk->pending, 1);
+    pthread_mutex_lock(&w->lock);
+    if (w->tail == w->cap) {
+        if (w->head > 0) {
+            memmove(w->items, w->items + w->head,
+                    (w->tail - w->head) * sizeof(struct item));
+            w->tail -= w->head;
+            w->head = 0;
+        } else {
+            w->cap = w->cap ? w->cap * 2 : 64;
+            w->items = realloc(w->items, w->cap * sizeof(struct item));
+            if (w->items == NULL) {
+                perror("realloc failed in push()");
+                exit(-1);
+            }
+        }
+    }
+    w->items[w->tail++] = (struct item){ prefix, len, seg };
+    pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * takes the dir the worker queued last. deep dirs first keeps the
+ * queue short
+ */
+static bool pop (struct worker *w, struct item *it)
+{
+    bool got = false;
+    pthread_mutex_lock(&w->lock);
+    if (w->tail > w->head) {
+        *it = w->items[--w->tail];
+        got = true;
+    }
+    if (w->tail == w->head) {
+        w->head = w->tail = 0;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return got;
+}
+
+/**
+ * takes the oldest dir queued by some other worker. those are the
+ * ones nearest the top, so likely to have the most under them
+ */
+static bool steal (struct worker *w, struct item *it)
+{
+    struct walk *walk = w->walk;
+    for (int k = 1; k < walk->worker_ct; k++) {
+        struct worker *victim = &walk->workers[(w->id + k) % walk->worker_ct];
+        bool got = false;
+        pthread_mutex_lock(&victim->lock);
+        if (victim->tail > victim->head) {
+            *it = victim->items[victim->head++];
+            got = true;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (got) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * qsort() order of paths
+ */
+static int by_path (const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
@@ -0,0 +1,442 @@
+/************************************************
+ *       Shippensburg University Shell          *
+ *                 zerocopy.c                   *
+ ************************************************
+ * cat, copy and tee builtins that have the     *
+ * kernel move the data. copy_file_range() for  *
+ * file to file, splice() when a pipe is on     *
+ * either end, tee() to duplicate a pipe, and   *
+ * sendfile() for the rest                      *
+ ************************************************
+ * Author: Justin Weigle                        *
+ *         Richard Bucco                        *
+ * Edited: 16 Oct 2026                          *
+ ************************************************/
+
+#define _GNU_SOURCE
+#include "../includes/zerocopy.h"
+#include "../includes/executor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/sendfile.h>
+
+#define MOVE_SIZE (1 << 20) // most bytes asked for per call
+
+/* how move_data() is moving bytes, best first */
+enum MOVE_METHOD {
+    MOVE_COPY_RANGE,
+    MOVE_SPLICE,
+    MOVE_SENDFILE,
+    MOVE_READ_WRITE
+};
+
+static bool move_data (int, int);
+static enum MOVE_METHOD first_method (struct stat *, struct stat *);
+static ssize_t move_some (enum MOVE_METHOD, int, int);
+static bool tee_pipe (int, int *, int);
+static bool same_file (int, int);
+static bool copy_file (const char *, const char *);
+static int run_external (char **);
+
+/**
+ * cat [-u] [file ...]
+ * writes each file, or stdin for - or no files, to stdout. anything
+ * with other options is left to the real cat
+ */
+int cat_cmd (int argc, char **argv)
+{
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (!strcmp(argv[i], "--")) {
+            i++;
+            break;
+        }
+        if (strcmp(argv[i], "-u")) {
+            return run_external(argv); // -n, -A and friends
+        }
+    }
+
+    int err = 0;
+    bool any = i < argc;
+    for (; i < argc || !any; i++) {
+        bool use_stdin = !any || !strcmp(argv[i], "-");
+        any = true;
+        int fd = use_stdin ? STDIN_FILENO : open(argv[i], O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "cat: %s: %s\n", argv[i], strerror(errno));
+            err = 1;
+            continue;
+        }
+        const char *name = use_stdin ? "-" : argv[i];
+        if (same_file(fd, STDOUT_FILENO)) {
+            fprintf(stderr, "cat: %s: input file is output file\n", name);
+            err = 1;
+        } else if (!move_data(fd, STDOUT_FILENO)) {
+            if (errno != EPIPE && !builtin_interrupted()) {
+                fprintf(stderr, "cat: %s: %s\n", name, strerror(errno));
+            }
+            err = 1;
+        }
+        if (!use_stdin) {
+            close(fd);
+        }
+        if (errno == EPIPE || builtin_interrupted()) {
+            break; // nobody is reading anymore, or ^C
+        }
+    }
+    return err;
+}
+
+/**
+ * copy src dst  or  copy src ... dir
+ * copies files without their bytes ever leaving the kernel, or even
+ * the filesystem when it can share extents
+ */
+int copy_cmd (int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: copy src dst  or  copy src ... dir\n");
+        return 2;
+    }
+    const char *dst = argv[argc-1];
+    struct stat st;
+    bool to_dir = stat(dst, &st) == 0 && S_ISDIR(st.st_mode);
+    if (argc > 3 && !to_dir) {
+        fprintf(stderr, "copy: %s is not a directory\n", dst);
+        return 1;
+    }
+
+    int err = 0;
+    for (int i = 1; i < argc-1; i++) {
+        if (!to_dir) {
+            err |= copy_file(argv[i], dst);
+            continue;
+        }
+        char path[PATH_MAX];
+        char src[strlen(argv[i]) + 1];
+        strcpy(src, argv[i]); // basename() may change it
+        snprintf(path, sizeof(path), "%s/%s", dst, basename(src));
+        err |= copy_file(argv[i], path);
+    }
+    return err;
+}
+
+/**
+ * tee [-a] [file ...]
+ * copies stdin to stdout and to every file, appending with -a. when
+ * stdin and stdout are both pipes the data is duplicated with tee()
+ * and spliced into the files, so it never gets copied to user space
+ */
+int tee_cmd (int argc, char **argv)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    int i = 1;
+    if (i < argc && !strcmp(argv[i], "-a")) {
+        flags = O_WRONLY | O_CREAT | O_APPEND;
+        i++;
+    }
+
+    int err = 0;
+    int fds[argc];
+    int fd_ct = 0;
+    for (; i < argc; i++) {
+        int fd = open(argv[i], flags, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "tee: %s: %s\n", argv[i], strerror(errno));
+            err = 1;
+        } else {
+            fds[fd_ct++] = fd;
+        }
+    }
+
+    struct stat in;
+    struct stat out;
+    bool ok;
+    if (fstat(STDIN_FILENO, &in) == 0 && fstat(STDOUT_FILENO, &out) == 0
+            && S_ISFIFO(in.st_mode) && S_ISFIFO(out.st_mode)) {
+        ok = tee_pipe(STDIN_FILENO, fds, fd_ct);
+    } else {
+        /* the slow way, through a buffer */
+        char buf[65536];
+        ssize_t n;
+        ok = true;
+        while (ok && (n = read(STDIN_FILENO, buf, sizeof(buf))) != 0) {
+            if (n < 0) {
+                ok = errno == EINTR && !builtin_interrupted();
+                continue;
+            }
+            ok = write(STDOUT_FILENO, buf, n) == n;
+            for (int f = 0; f < fd_ct; f++) {
+                if (write(fds[f], buf, n) != n) {
+                    ok = false;
+                }
+            }
+        }
+    }
+    if (!ok && errno != EPIPE && !builtin_interrupted()) {
+        perror("tee");
+        err = 1;
+    }
+    for (int f = 0; f < fd_ct; f++) {
+        close(fds[f]);
+    }
+    return err;
+}
+
+/**
+ * moves everything from in to out the cheapest way the two fds allow.
+ * returns false with errno set if it couldn't
+ */
+static bool move_data (int in, int out)
+{
+    struct stat in_st;
+    struct stat out_st;
+    if (fstat(in, &in_st) < 0 || fstat(out, &out_st) < 0) {
+        return false;
+    }
+    enum MOVE_METHOD method = first_method(&in_st, &out_st);
+    while (true) {
+        if (builtin_interrupted()) {
+            errno = EINTR;
+            return false;
+        }
+        ssize_t n = move_some(method, in, out);
+        if (n > 0) {
+            continue;
+        }
+        if (n == 0) {
+            return true;
+        }
+        if (errno == EINTR || errno == EAGAIN) {
+            continue;
+        }
+        if ((errno == EINVAL || errno == ENOSYS || errno == EXDEV
+                    || errno == EOPNOTSUPP) && method != MOVE_READ_WRITE) {
+            method++; // not for these fds, try the next best way
+            if (method == MOVE_SPLICE && !S_ISFIFO(in_st.st_mode)
+                    && !S_ISFIFO(out_st.st_mode)) {
+                method++;
+            }
+            if (method == MOVE_SENDFILE && !S_ISREG(in_st.st_mode)) {
+                method++;
+            }
+            continue;
+        }
+        return false;
+    }
+}
+
+/**
+ * the best way to move from in to out, going by what they are
+ */
+static enum MOVE_METHOD first_method (struct stat *in, struct stat *out)
+{
+    if (S_ISREG(in->st_mode) && S_ISREG(out->st_mode)) {
+        return MOVE_COPY_RANGE;
+    }
+    if (S_ISFIFO(in->st_mode) || S_ISFIFO(out->st_mode)) {
+        return MOVE_SPLICE;
+    }
+    if (S_ISREG(in->st_mode)) {
+        return MOVE_SENDFILE;
+    }
+    return MOVE_READ_WRITE;
+}
+
+/**
+ * moves up to MOVE_SIZE bytes one way. returns how many, 0 at the end
+ * of in, or -1 with errno set
+ */
+static ssize_t move_some (enum MOVE_METHOD method, int in, int out)
+{
+    switch (method) {
+    case MOVE_COPY_RANGE:
+        return copy_file_range(in, NULL, out, NULL, MOVE_SIZE, 0);
+    case MOVE_SPLICE:
+        return splice(in, NULL, out, NULL, MOVE_SIZE, SPLICE_F_MOVE);
+    case MOVE_SENDFILE:
+        return sendfile(out, in, NULL, MOVE_SIZE);
+    default:
+        break;
+    }
+    char buf[65536];
+    ssize_t n = read(in, buf, sizeof(buf));
+    for (ssize_t done = 0; done < n;) {
+        ssize_t w = write(out, buf + done, n - done);
+        if (w < 0) {
+            if (errno == EINTR && !builtin_interrupted()) {
+                continue;
+            }
+            return -1;
+        }
+        done += w;
+    }
+    return n;
+}
+
+/**
+ * duplicates the pipe in onto stdout with tee(), then moves each
+ * chunk into the files with splice(). every file but the last gets
+ * its own tee() into a spare pipe since splice() uses the data up.
+ * tee() always copies from the front of in, so a chunk is never more
+ * than the spare pipe holds. returns false with errno set on error
+ */
+static bool tee_pipe (int in, int *fds, int fd_ct)
+{
+    int spare[2] = { -1, -1 };
+    ssize_t chunk = MOVE_SIZE;
+    if (fd_ct > 1) {
+        if (pipe(spare) < 0) {
+            return false;
+        }
+        int in_size = fcntl(in, F_GETPIPE_SZ);
+        if (in_size > 0) {
+            fcntl(spare[1], F_SETPIPE_SZ, in_size); // as big as allowed
+        }
+        int spare_size = fcntl(spare[1], F_GETPIPE_SZ);
+        if (spare_size > 0 && spare_size < chunk) {
+            chunk = spare_size;
+        }
+    }
+    bool ok = true;
+    while (ok) {
+        ssize_t n = tee(in, STDOUT_FILENO, chunk, 0);
+        if (n < 0 && errno == EINTR && !builtin_interrupted()) {
+            continue;
+        }
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+        for (int f = 0; ok && f < fd_ct - 1; f++) {
+            ssize_t dup = tee(in, spare[1], n, 0);
+            if (dup < 0 && errno == EINTR && !builtin_interrupted()) {
+                f--; // try this file again
+                continue;
+            }
+            if (dup != n) {
+                if (dup >= 0) {
+                    errno = EIO; // the spare pipe should have held it all
+                }
+                ok = false;
+                break;
+            }
+            for (ssize_t left = dup; ok && left > 0;) {
+                ssize_t s = splice(spare[0], NULL, fds[f], NULL, left,
+                        SPLICE_F_MOVE);
+                if (s < 0 && errno == EINTR && !builtin_interrupted()) {
+                    continue;
+                }
+                if (s == 0) {
+                    errno = EIO;
+                }
+                ok = s > 0;
+                left -= s;
+            }
+        }
+
+        /* the last file, or nothing, takes the data out of the pipe */
+        for (ssize_t left = n; ok && left > 0;) {
+            ssize_t s;
+            if (fd_ct > 0) {
+                s = splice(in, NULL, fds[fd_ct-1], NULL, left, SPLICE_F_MOVE);
+            } else {
+                char buf[65536];
+                s = read(in, buf, left < (ssize_t)sizeof(buf)
+                        ? left : (ssize_t)sizeof(buf));
+            }
+            if (s < 0 && errno == EINTR && !builtin_interrupted()) {
+                continue;
+            }
+            if (s == 0) {
+                errno = EIO; // the data tee() saw has gone
+            }
+            ok = s > 0;
+            left -= s;
+        }
+    }
+    if (spare[0] >= 0) {
+        close(spare[0]);
+        close(spare[1]);
+    }
+    return ok;
+}
+
+/**
+ * true if a and b are the same regular file, where cat would read
+ * what it had just written forever
+ */
+static bool same_file (int a, int b)
+{
+    struct stat sa;
+    struct stat sb;
+    return fstat(a, &sa) == 0 && fstat(b, &sb) == 0 && S_ISREG(sa.st_mode)
+        && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+/**
+ * copies the file src to dst, which gets src's permissions if it's
+ * new. returns true on error
+ */
+static bool copy_file (const char *src, const char *dst)
+{
+    int in = open(src, O_RDONLY);
+    struct stat st;
+    if (in < 0 || fstat(in, &st) < 0) {
+        fprintf(stderr, "copy: %s: %s\n", src, strerror(errno));
+        if (in >= 0) {
+            close(in);
+        }
+        return true; // error
+    }
+    /* not truncated until it is known not to be src */
+    int out = open(dst, O_WRONLY | O_CREAT, st.st_mode & 07777);
+    if (out < 0) {
+        fprintf(stderr, "copy: %s: %s\n", dst, strerror(errno));
+        close(in);
+        return true; // error
+    }
+    bool err = false;
+    if (same_file(in, out)) {
+        fprintf(stderr, "copy: %s and %s are the same file\n", src, dst);
+        err = true;
+    } else if (ftruncate(out, 0) < 0 || !move_data(in, out)) {
+        fprintf(stderr, "copy: %s: %s\n", dst, strerror(errno));
+        err = true;
+    }
+    close(in);
+    close(out);
+    return err;
+}
+
+/**
+ * runs the real command for options the builtin doesn't handle and
+ * waits for it. returns its exit status
+ */
+static int run_external (char **argv)
+{
+    pid_t pid = spawn_argv(argv, STDIN_FILENO, STDOUT_FILENO,
+            STDERR_FILENO);
+    int status;
+    if (pid < 0) {
+        return 127;
+    }
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return 1;
+        }
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return WEXITSTATUS(status);
+}
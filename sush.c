@@ -5,12 +5,12 @@
  * Linux shell command interpreter.             *
  * Reads a .sushrc file from the user's home    *
  * directory and execs it line by line if it is *
- * executable, then waits for user input to     *
- * tokenize and run commands                    *
+ * executable, then runs commands from -c, a    *
+ * script file, or standard input               *
  ************************************************
  * Author: Justin Weigle                        *
  *         Richard Bucco                        *
- * Edited: 19 Apr 2020                          *
+ * Edited: 16 Oct 2026                          *
  ************************************************/
 
 #include "includes/sush.h"
@@ -18,67 +18,245 @@
 #include "includes/executor.h"
 #include "includes/internal.h"
 #include "includes/rcreader.h"
+#include "includes/profile.h"
+#include "includes/jobs.h"
+#include "includes/history.h"
+#include "includes/vars.h"
+#include "includes/cmdhash.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <signal.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 
+static void run_line (struct tok_list *);
+static void run_input (int, bool);
+static void run_string (char *);
+static void print_prompt (struct tok_list *);
+static void usage ();
 static void print_resources (struct rusage);
 static void show_resources (int);
-static void show_child_resources (int);
+static void show_child_resources ();
+
+static int status = 0; // exit status of the last command line
 
 int main (int argc, char **argv)
 {
+    char *cmd_string = NULL;
+    char *script = NULL;
+    int arg = 1;
+    if (arg < argc && !strcmp(argv[arg], "--startup-profile")) {
+        profile_enable();
+        arg++;
+    }
+    long long startup = profile_now();
+    if (arg < argc) {
+        if (!strcmp(argv[arg], "-c")) {
+            if (arg+1 >= argc) {
+                usage();
+            }
+            cmd_string = argv[arg+1];
+        } else if (argv[arg][0] == '-') {
+            usage();
+        } else {
+            script = argv[arg];
+        }
+    }
+    bool interactive = cmd_string == NULL && script == NULL
+        && isatty(STDIN_FILENO);
+
+    long long start = profile_now();
     signal(SIGINT, SIG_IGN);
     signal(SIGUSR1, show_resources);
     signal(SIGUSR2, show_all_resources);
-    signal(SIGCHLD, show_child_resources);
+    jobs_init(interactive); // SIGCHLD is read from a signalfd from now on
+    profile_report("signals", start, "handlers installed");
 
     read_sushrc();
+    profile_report("total", startup, "ready to run commands");
+
+    if (cmd_string != NULL) {
+        run_string(cmd_string);
+    } else if (script != NULL) {
+        int fd = open(script, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            perror(script);
+            exit(127);
+        }
+        run_input(fd, false);
+        close(fd);
+    } else {
+        run_input(STDIN_FILENO, interactive);
+    }
+
+    return status;
+}
+
+/**
+ * exit status of the last command line that was run
+ */
+int last_status ()
+{
+    return status;
+}
 
+/**
+ * reads commands from fd until EOF and runs each line as soon as it
+ * has been tokenized. prompts are only printed and lines only kept
+ * in the history if interactive, and input is read in blocks of
+ * READ_SIZE, however many lines that is
+ */
+static void run_input (int fd, bool interactive)
+{
     struct tok_list tlist;
-    tlist.head = NULL;
-    tlist.tail = NULL;
-    tlist.count = 0;
-    tlist.pcount = 0;
-
-    char userin[BUFF_SIZE];
-    while (!feof(stdin)) {
-        char *PS1 = getenv("PS1");
-        if (PS1 == NULL) {
-            printf("$ ");
-        } else {
-            printf("%s", PS1);
+    init_tok_list(&tlist);
+
+    char *userin = malloc(READ_SIZE);
+    if (userin == NULL) {
+        perror("malloc failed in run_input()");
+        exit(-1);
+    }
+    bool line_start = true; // last chunk read ended a line
+    while (true) {
+        if (line_start) {
+            /* scripts don't want a report after every cmd */
+            if (jobs_reap() && interactive) {
+                show_child_resources();
+            }
+            jobs_notify();
+            if (interactive) {
+                print_prompt(&tlist);
+            }
+        }
+
+        /* reap background jobs as they finish while waiting for input */
+        while (!jobs_wait_input(fd)) {
+            if (jobs_reap() && interactive) {
+                show_child_resources();
+            }
+        }
+
+        /* get user input, a line from a terminal or a block otherwise */
+        int length = read(fd, userin, READ_SIZE);
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            if (length < 0) {
+                perror("read failed in run_input()");
+            }
+            /* finish a last line that had no newline */
+            if (tokenize_end(&tlist) == TOK_DONE && tlist.count) {
+                run_line(&tlist);
+            }
+            break;
         }
+        line_start = userin[length-1] == '\n';
+
+        /* tokenize the input, running each line as it is finished.
+         * what was typed goes into the history as it was typed */
+        for (int off = 0, used = 0; off < length; off += used) {
+            enum TOK_STATUS ret = tokenize_chunk(&tlist, userin + off,
+                    length - off, &used);
+            if (interactive) {
+                history_collect(userin + off, used);
+                if (ret != TOK_MORE) {
+                    history_end_line();
+                }
+            }
+            if (ret != TOK_DONE) {
+                continue;
+            }
 
-        /* get user input */
-        if (fgets(userin, BUFF_SIZE, stdin) == NULL) {
-            exit(0);
+            /* print the tokenized input */
+//            print_tokens(&tlist);
+
+            /* exec tokenized input */
+            if (tlist.count) {
+                run_line(&tlist);
+            }
+
+            /* free the tokenized input */
+            free_tok_list(&tlist);
         }
+    }
 
-        /* tokenize the input */
-        tokenize(&tlist, userin);
+    free(userin);
+    destroy_tok_list(&tlist);
+}
 
-        /* print the tokenized input */
-//        print_tokens(tlist.head);
+/**
+ * runs the commands in str, for sush -c
+ */
+static void run_string (char *str)
+{
+    struct tok_list tlist;
+    init_tok_list(&tlist);
 
-        /* exec tokenized input */
-        if (tlist.head) {
-            int ret = run_internal_cmd(&tlist);
-            if (ret < 0) {
-                fprintf(stderr,"Unable to run internal command\n");
-            } else if (ret > 0) { // wasn't an internal command
-                execute(&tlist);
+    int length = strlen(str);
+    for (int off = 0, used = 0; off < length; off += used) {
+        if (tokenize_chunk(&tlist, str + off, length - off, &used)
+                == TOK_DONE) {
+            if (tlist.count) {
+                run_line(&tlist);
             }
+            free_tok_list(&tlist);
         }
+    }
+    if (tokenize_end(&tlist) == TOK_DONE && tlist.count) {
+        run_line(&tlist);
+    }
+
+    destroy_tok_list(&tlist);
+}
+
+/**
+ * prints $PS1, or $PS2 if the last line isn't finished yet
+ */
+static void print_prompt (struct tok_list *tlist)
+{
+    const char *PS1 = var_get("PS1");
+    const char *PS2 = var_get("PS2");
+    if (tokenize_pending(tlist)) { // line continues
+        printf("%s", PS2 ? PS2 : "> ");
+    } else if (PS1 == NULL) {
+        printf("$ ");
+    } else {
+        printf("%s", PS1);
+    }
+    fflush(stdout); // read() doesn't flush stdout like fgets() did
+}
 
-        /* free the tokenized input */
-        free_tok_list(&tlist);
+/**
+ * runs a tokenized line as an internal command if it is one,
+ * or as external command(s) if it isn't, and remembers its status
+ */
+static void run_line (struct tok_list *tlist)
+{
+    cmd_hash_new_line();
+    int ret = run_internal_cmd(tlist);
+    if (ret < 0) {
+        fprintf(stderr,"Unable to run internal command\n");
+        status = 1;
+    } else if (ret > 0) { // wasn't an internal command
+        status = execute(tlist);
+    } else {
+        status = 0;
     }
+}
 
-    return 0;
+/**
+ * how to start sush
+ */
+static void usage ()
+{
+    fprintf(stderr, "usage: sush [--startup-profile] [-c command | script]\n");
+    exit(2);
 }
 
 /**
@@ -102,7 +280,16 @@ void manage_rusage (enum RMANAGE setting, struct rusage usage)
         total_usage.ru_stime.tv_sec += time1;
         total_usage.ru_stime.tv_usec += time2;
 
-        total_usage.ru_maxrss   +=  usage.ru_maxrss;
+        /* keep tv_usec under a second */
+        total_usage.ru_utime.tv_sec += total_usage.ru_utime.tv_usec / 1000000;
+        total_usage.ru_utime.tv_usec %= 1000000;
+        total_usage.ru_stime.tv_sec += total_usage.ru_stime.tv_usec / 1000000;
+        total_usage.ru_stime.tv_usec %= 1000000;
+
+        /* a sum of peaks means nothing, keep the biggest */
+        if (usage.ru_maxrss > total_usage.ru_maxrss) {
+            total_usage.ru_maxrss = usage.ru_maxrss;
+        }
         total_usage.ru_ixrss    +=  usage.ru_ixrss;
         total_usage.ru_idrss    +=  usage.ru_idrss;
         total_usage.ru_isrss    +=  usage.ru_isrss;
@@ -143,10 +330,10 @@ static void print_resources (struct rusage usage)
     time_t time2;
     time1 = usage.ru_utime.tv_sec;
     time2 = usage.ru_utime.tv_usec;
-    printf("ru_utime    %ld.%ld\n", time1, time2);
+    printf("ru_utime    %ld.%06ld\n", time1, time2);
     time1 = usage.ru_stime.tv_sec;
     time2 = usage.ru_stime.tv_usec;
-    printf("ru_stime    %ld.%ld\n", time1, time2);
+    printf("ru_stime    %ld.%06ld\n", time1, time2);
     printf("ru_maxrss   %ld\n",   usage.ru_maxrss);
     printf("ru_ixrss    %ld\n",    usage.ru_ixrss);
     printf("ru_idrss    %ld\n",    usage.ru_idrss);
@@ -174,9 +361,10 @@ static void show_resources (int sig) {
 }
 
 /**
- * prints resource usage of only child processes
+ * prints resource usage of only child processes, after children
+ * have been reaped
  */
-static void show_child_resources (int sig) {
+static void show_child_resources () {
     struct rusage ruse;
     getrusage(RUSAGE_CHILDREN, &ruse);
     print_resources(ruse);